@@ -0,0 +1,112 @@
+#ifndef POMODORO_EFFECT_EXECUTOR_H
+#define POMODORO_EFFECT_EXECUTOR_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "pomodoro_fsm.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define EFFECT_EXECUTOR_QUEUE_LENGTH 8
+#define EFFECT_EXECUTOR_MAX_JOBS 4
+
+// Returned by a step function when the job has nothing left to do
+#define EFFECT_JOB_DONE UINT32_MAX
+
+typedef struct pomodoro_effect_job pomodoro_effect_job_t;
+
+/*
+ * @brief Runs one step of a job.
+ *
+ * Steps must never block: anything that takes time (a buzzer pattern, an LED
+ * fade) is split into steps, and the executor calls back when the next one is
+ * due. `job->step` counts the calls so far, starting at 0.
+ *
+ * When the job is cancelled the function is called one last time with
+ * `job->cancelled` set, so it can leave its outputs in a sane state. The
+ * return value of that call is ignored.
+ *
+ * @return milliseconds until the next step, or EFFECT_JOB_DONE.
+ */
+typedef uint32_t (*pomodoro_effect_job_step_fn)(pomodoro_effect_job_t *job);
+
+struct pomodoro_effect_job {
+  pomodoro_effect_job_step_fn step_fn;
+  void *ctx;
+  pomodoro_effect_t effect; // Copied: the reactor's effects are short-lived
+  uint32_t generation;      // Transition this job belongs to
+  uint32_t step;
+  uint32_t wake_ms;
+  bool cancelled;
+};
+
+typedef struct pomodoro_effect_binding {
+  pomodoro_effect_job_step_fn step_fn;
+  void *ctx;
+} pomodoro_effect_binding_t;
+
+// `dropped` is written by the reactor and the rest by the executor task, read
+// them with atomic_load()
+typedef struct pomodoro_effect_executor_stats {
+  _Atomic uint32_t submitted;
+  _Atomic uint32_t completed;
+  _Atomic uint32_t cancelled;
+  _Atomic uint32_t dropped; // Queue full at submission time
+} pomodoro_effect_executor_stats_t;
+
+/*
+ * @brief Runs slow effects on their own task so the reactor never waits on
+ * effect I/O.
+ *
+ * The reactor side (`pomodoro_effect_executor_handle_effect` and
+ * `pomodoro_effect_executor_supersede`) only ever does a non-blocking queue
+ * send and an atomic increment. Every job is tagged with the transition it was
+ * submitted in; once a newer transition happens, older jobs are cancelled
+ * before their next step.
+ */
+typedef struct pomodoro_effect_executor {
+  QueueHandle_t queue;
+  atomic_uint_fast32_t generation;
+  pomodoro_effect_binding_t bindings[POMODORO_EFFECT_TYPE_COUNT];
+
+  // Owned by the executor task
+  pomodoro_effect_job_t jobs[EFFECT_EXECUTOR_MAX_JOBS];
+  uint32_t job_count;
+
+  pomodoro_effect_executor_stats_t stats;
+} pomodoro_effect_executor_t;
+
+void pomodoro_effect_executor_initialize(pomodoro_effect_executor_t *executor);
+
+/*
+ * @brief Runs `step_fn` as a job whenever an effect of type `type` is handled.
+ * Must be called before the executor task starts.
+ */
+void pomodoro_effect_executor_bind(pomodoro_effect_executor_t *executor,
+                                   pomodoro_effect_type_t type,
+                                   pomodoro_effect_job_step_fn step_fn,
+                                   void *ctx);
+
+/*
+ * @brief Mask of the bound effect types, to register on the effect bus.
+ */
+uint32_t
+pomodoro_effect_executor_mask(const pomodoro_effect_executor_t *executor);
+
+/*
+ * @brief Marks the start of a new transition: jobs submitted before this call
+ * are cancelled. Called by the reactor before dispatching effects.
+ */
+void pomodoro_effect_executor_supersede(pomodoro_effect_executor_t *executor);
+
+/*
+ * @brief Effect bus handler, `ctx` is a `pomodoro_effect_executor_t`. Never
+ * blocks: if the queue is full, the effect is dropped and counted.
+ */
+void pomodoro_effect_executor_handle_effect(void *ctx,
+                                            const pomodoro_effect_t *effect);
+
+void pomodoro_effect_executor_task(void *args);
+
+#endif // POMODORO_EFFECT_EXECUTOR_H
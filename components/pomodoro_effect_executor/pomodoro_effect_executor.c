@@ -0,0 +1,187 @@
+#include "pomodoro_effect_executor.h"
+#include "freertos/task.h"
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+void pomodoro_effect_executor_initialize(pomodoro_effect_executor_t *executor) {
+  assert(executor != NULL);
+
+  memset(executor, 0, sizeof(*executor));
+  atomic_init(&executor->generation, 0);
+  atomic_init(&executor->stats.submitted, 0);
+  atomic_init(&executor->stats.completed, 0);
+  atomic_init(&executor->stats.cancelled, 0);
+  atomic_init(&executor->stats.dropped, 0);
+
+  executor->queue =
+      xQueueCreate(EFFECT_EXECUTOR_QUEUE_LENGTH, sizeof(pomodoro_effect_job_t));
+  configASSERT(executor->queue);
+}
+
+void pomodoro_effect_executor_bind(pomodoro_effect_executor_t *executor,
+                                   pomodoro_effect_type_t type,
+                                   pomodoro_effect_job_step_fn step_fn,
+                                   void *ctx) {
+  assert(executor != NULL);
+  assert(type < POMODORO_EFFECT_TYPE_COUNT);
+
+  executor->bindings[type] =
+      (pomodoro_effect_binding_t){.step_fn = step_fn, .ctx = ctx};
+}
+
+uint32_t
+pomodoro_effect_executor_mask(const pomodoro_effect_executor_t *executor) {
+  uint32_t mask = 0;
+  for (uint32_t type = 0; type < POMODORO_EFFECT_TYPE_COUNT; type++) {
+    if (executor->bindings[type].step_fn != NULL) {
+      mask |= 1u << type;
+    }
+  }
+  return mask;
+}
+
+void pomodoro_effect_executor_supersede(pomodoro_effect_executor_t *executor) {
+  atomic_fetch_add(&executor->generation, 1);
+}
+
+void pomodoro_effect_executor_handle_effect(void *ctx,
+                                            const pomodoro_effect_t *effect) {
+  pomodoro_effect_executor_t *executor = (pomodoro_effect_executor_t *)ctx;
+  const pomodoro_effect_binding_t *binding = &executor->bindings[effect->type];
+
+  if (binding->step_fn == NULL) {
+    return;
+  }
+
+  pomodoro_effect_job_t job = {
+      .step_fn = binding->step_fn,
+      .ctx = binding->ctx,
+      .effect = *effect,
+      .generation = atomic_load(&executor->generation),
+  };
+
+  // Never wait on the executor: a full queue means it is already behind
+  if (xQueueSend(executor->queue, &job, 0) != pdTRUE) {
+    atomic_fetch_add(&executor->stats.dropped, 1);
+  }
+}
+
+// === Executor task ===
+
+static void remove_job(pomodoro_effect_executor_t *executor, uint32_t index) {
+  executor->jobs[index] = executor->jobs[executor->job_count - 1];
+  executor->job_count--;
+}
+
+static void cancel_job(pomodoro_effect_executor_t *executor, uint32_t index) {
+  pomodoro_effect_job_t *job = &executor->jobs[index];
+  job->cancelled = true;
+  job->step_fn(job);
+  atomic_fetch_add(&executor->stats.cancelled, 1);
+  remove_job(executor, index);
+}
+
+static void admit_job(pomodoro_effect_executor_t *executor,
+                      const pomodoro_effect_job_t *job, uint32_t now_ms) {
+  atomic_fetch_add(&executor->stats.submitted, 1);
+
+  if (executor->job_count == EFFECT_EXECUTOR_MAX_JOBS) {
+    // Newer effects win: make room by cancelling the oldest job
+    uint32_t oldest = 0;
+    for (uint32_t i = 1; i < executor->job_count; i++) {
+      if ((int32_t)(executor->jobs[i].generation -
+                    executor->jobs[oldest].generation) < 0) {
+        oldest = i;
+      }
+    }
+    cancel_job(executor, oldest);
+  }
+
+  pomodoro_effect_job_t *slot = &executor->jobs[executor->job_count++];
+  *slot = *job;
+  slot->step = 0;
+  slot->wake_ms = now_ms;
+  slot->cancelled = false;
+}
+
+static void cancel_superseded_jobs(pomodoro_effect_executor_t *executor) {
+  uint32_t generation = atomic_load(&executor->generation);
+
+  uint32_t i = 0;
+  while (i < executor->job_count) {
+    if (executor->jobs[i].generation != generation) {
+      cancel_job(executor, i); // Moves the last job into `i`
+    } else {
+      i++;
+    }
+  }
+}
+
+static void run_due_jobs(pomodoro_effect_executor_t *executor,
+                         uint32_t now_ms) {
+  uint32_t i = 0;
+  while (i < executor->job_count) {
+    pomodoro_effect_job_t *job = &executor->jobs[i];
+
+    if ((int32_t)(job->wake_ms - now_ms) > 0) {
+      i++;
+      continue;
+    }
+
+    uint32_t delay_ms = job->step_fn(job);
+    job->step++;
+
+    if (delay_ms == EFFECT_JOB_DONE) {
+      atomic_fetch_add(&executor->stats.completed, 1);
+      remove_job(executor, i);
+    } else {
+      job->wake_ms = now_ms + delay_ms;
+      i++;
+    }
+  }
+}
+
+static TickType_t
+ticks_until_next_step(const pomodoro_effect_executor_t *executor,
+                      uint32_t now_ms) {
+  if (executor->job_count == 0) {
+    return portMAX_DELAY;
+  }
+
+  int32_t earliest = INT32_MAX;
+  for (uint32_t i = 0; i < executor->job_count; i++) {
+    int32_t until = (int32_t)(executor->jobs[i].wake_ms - now_ms);
+    if (until < earliest) {
+      earliest = until;
+    }
+  }
+  if (earliest <= 0) {
+    return 0;
+  }
+  // Rounded up: pdMS_TO_TICKS() gives 0 below one tick, and the task would
+  // spin until the step is due
+  return ((TickType_t)earliest + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+}
+
+void pomodoro_effect_executor_task(void *args) {
+  pomodoro_effect_executor_t *executor = (pomodoro_effect_executor_t *)args;
+  pomodoro_effect_job_t job;
+
+  while (true) {
+    uint32_t now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+    TickType_t wait = ticks_until_next_step(executor, now_ms);
+
+    // Drain everything that arrived while the previous steps ran
+    if (xQueueReceive(executor->queue, &job, wait)) {
+      now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+      do {
+        admit_job(executor, &job, now_ms);
+      } while (xQueueReceive(executor->queue, &job, 0));
+    }
+
+    now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+    cancel_superseded_jobs(executor);
+    run_due_jobs(executor, now_ms);
+  }
+}
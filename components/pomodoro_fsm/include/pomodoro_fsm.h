@@ -1,6 +1,7 @@
 #ifndef POMODORO_FSM_H
 #define POMODORO_FSM_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 typedef enum pomodoro_err {
@@ -48,21 +49,96 @@ typedef enum pomodoro_event {
   POMODORO_EVT_SKIP,
   POMODORO_EVT_TIMEOUT,
   POMODORO_EVT_RESTART,
+  // Reminder deadlines, see pomodoro_timer_id_t
+  POMODORO_EVT_WARNING,
+  POMODORO_EVT_HALFWAY,
+  POMODORO_EVT_PAUSE_REMINDER,
   // MUST BE LAST: Used for getting the count
   POMODORO_EVT_COUNT,
 } pomodoro_event_t;
 
+/*
+ * @brief Named deadlines a session can have pending at the same time. Each one
+ * produces its own event when it expires.
+ */
+typedef enum pomodoro_timer_id {
+  POMODORO_TIMER_PHASE_END = 0,  // -> POMODORO_EVT_TIMEOUT
+  POMODORO_TIMER_WARNING,        // POMODORO_WARNING_LEAD_MS before the end
+  POMODORO_TIMER_HALFWAY,        // Half of the phase duration elapsed
+  POMODORO_TIMER_PAUSE_REMINDER, // Paused for POMODORO_PAUSE_REMINDER_MS
+  // MUST BE LAST: Used for getting the count
+  POMODORO_TIMER_COUNT,
+} pomodoro_timer_id_t;
+
+// Only valid for POMODORO_EFFECT_TIMER_STOP: stops every pending deadline
+#define POMODORO_TIMER_ALL POMODORO_TIMER_COUNT
+
+#define POMODORO_WARNING_LEAD_MS (60u * 1000u)
+#define POMODORO_PAUSE_REMINDER_MS (5u * 60u * 1000u)
+
+static inline pomodoro_event_t
+pomodoro_timer_event(pomodoro_timer_id_t timer_id) {
+  static const pomodoro_event_t timer_events[] = {
+      POMODORO_EVT_TIMEOUT,
+      POMODORO_EVT_WARNING,
+      POMODORO_EVT_HALFWAY,
+      POMODORO_EVT_PAUSE_REMINDER,
+  };
+  return (timer_id < POMODORO_TIMER_COUNT) ? timer_events[timer_id]
+                                           : POMODORO_EVT_COUNT;
+}
+
+// Reminders only produce a REMINDER effect, they never change the session
+static inline bool pomodoro_is_reminder_event(pomodoro_event_t event) {
+  return event == POMODORO_EVT_WARNING || event == POMODORO_EVT_HALFWAY ||
+         event == POMODORO_EVT_PAUSE_REMINDER;
+}
+
 typedef enum pomodoro_effect_type {
-  POMODORO_EFFECT_TIMER_START,
+  POMODORO_EFFECT_TIMER_START = 0,
   POMODORO_EFFECT_TIMER_STOP,
+  POMODORO_EFFECT_PHASE_CHANGED,
+  POMODORO_EFFECT_SESSION_FINISHED,
+  POMODORO_EFFECT_REMINDER,
+  // The session changed (state, phase or timing). Emitted last by every
+  // transition except the reminders.
+  POMODORO_EFFECT_SESSION_UPDATED,
+  // MUST BE LAST: Used for getting the count
+  POMODORO_EFFECT_TYPE_COUNT,
 } pomodoro_effect_type_t;
 
+static inline const char *
+pomodoro_effect_type_to_string(pomodoro_effect_type_t type) {
+  static const char *effect_names[] = {
+      "TIMER_START",
+      "TIMER_STOP",
+      "PHASE_CHANGED",
+      "SESSION_FINISHED",
+      "REMINDER",
+      "SESSION_UPDATED",
+  };
+  return (type < POMODORO_EFFECT_TYPE_COUNT) ? effect_names[type] : "UNKNOWN";
+}
+
 typedef struct pomodoro_effect {
   pomodoro_effect_type_t type;
   union {
     struct {
+      pomodoro_timer_id_t timer_id;
       uint32_t timeout_ms;
     } timer_start;
+    struct {
+      pomodoro_timer_id_t timer_id; // Or POMODORO_TIMER_ALL
+    } timer_stop;
+    struct {
+      uint32_t phase_index;
+    } phase_changed;
+    struct {
+      pomodoro_timer_id_t timer_id;
+    } reminder;
+    struct {
+      pomodoro_state_t state; // State after the transition
+    } session_updated;
   };
 } pomodoro_effect_t;
 
@@ -83,6 +159,8 @@ void pomodoro_effects_set(pomodoro_effects_t *effects,
 typedef struct pomodoro_phase {
   char name[MAX_NAME];
   uint32_t duration_ms;
+  // Counted as focused time by the statistics (e.g. "Work", not "Rest")
+  bool focus;
 } pomodoro_phase_t;
 
 #define MAX_PHASES 20
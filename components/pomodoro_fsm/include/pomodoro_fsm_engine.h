@@ -0,0 +1,294 @@
+/*
+ * @brief Transition table shared by the generic FSM (pomodoro_fsm.c) and the
+ * fixed-schedule FSMs (pomodoro_fsm_fixed.h). Not meant to be included
+ * directly.
+ *
+ * Every inclusion generates one engine, as `static inline` functions, from:
+ * - POMODORO_ENGINE_FN(name): prefixes the generated functions
+ * - POMODORO_ENGINE_SESSION_T: the session type. It needs the `state`,
+ *   `phase_index`, `end_time_ms` and `remaining_ms` fields of
+ *   pomodoro_session_t, though not necessarily with the same types
+ * - POMODORO_ENGINE_PHASE_COUNT(session)
+ * - POMODORO_ENGINE_DURATION_MS(session, phase_index)
+ *
+ * These are undefined at the end, so a translation unit may generate several
+ * engines. The generated `dispatch` expects a valid session and event: the
+ * callers do the argument checks they need.
+ */
+#include "pomodoro_fsm.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef POMODORO_FSM_ENGINE_COMMON
+#define POMODORO_FSM_ENGINE_COMMON
+
+/*
+ * @brief Allows for switching states and events without requiring multiple
+ * switches
+ */
+#define POMODORO_ENGINE_KEY(state, event)                                      \
+  ((state) * POMODORO_EVT_COUNT + (event))
+
+/*
+ * @brief For helpers called from several transitions: `-Os` keeps them out of
+ * line, though inlined they fold into the callers' stores and the dispatch
+ * code ends up smaller. See "Fixed schedules" in docs/architecture.md.
+ */
+#define POMODORO_ENGINE_ALWAYS_INLINE                                          \
+  static inline __attribute__((always_inline))
+
+#define POMODORO_ENGINE_STOP_ALL_TIMERS                                        \
+  ((pomodoro_effect_t){                                                        \
+      .type = POMODORO_EFFECT_TIMER_STOP,                                      \
+      .timer_stop.timer_id = POMODORO_TIMER_ALL,                               \
+  })
+
+static inline pomodoro_effect_t
+pomodoro_engine_timer_start(pomodoro_timer_id_t timer_id,
+                            uint32_t timeout_ms) {
+  return (pomodoro_effect_t){
+      .type = POMODORO_EFFECT_TIMER_START,
+      .timer_start.timer_id = timer_id,
+      .timer_start.timeout_ms = timeout_ms,
+  };
+}
+
+// Unchecked pomodoro_effects_set(): no transition produces more than
+// MAX_EFFECTS effects
+POMODORO_ENGINE_ALWAYS_INLINE void
+pomodoro_engine_effects_set(pomodoro_effects_t *effects,
+                            const pomodoro_effect_t effects_array[],
+                            uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    effects->effects[i] = effects_array[i];
+  }
+  effects->count = count;
+}
+
+#endif // POMODORO_FSM_ENGINE_COMMON
+
+#define POMODORO_ENGINE_CURRENT_DURATION_MS(session)                           \
+  POMODORO_ENGINE_DURATION_MS(session, (session)->phase_index)
+
+static inline bool
+POMODORO_ENGINE_FN(has_next_phase)(const POMODORO_ENGINE_SESSION_T *session) {
+  return session->phase_index + 1u < POMODORO_ENGINE_PHASE_COUNT(session);
+}
+
+static inline void
+POMODORO_ENGINE_FN(set_end_time_current_phase)(
+    POMODORO_ENGINE_SESSION_T *session, uint32_t now_ms) {
+  session->end_time_ms =
+      now_ms + POMODORO_ENGINE_CURRENT_DURATION_MS(session);
+}
+
+static inline void
+POMODORO_ENGINE_FN(advance_phase)(POMODORO_ENGINE_SESSION_T *session,
+                                  uint32_t now_ms) {
+  session->phase_index++;
+  POMODORO_ENGINE_FN(set_end_time_current_phase)(session, now_ms);
+}
+
+static inline void
+POMODORO_ENGINE_FN(store_remaining_time)(POMODORO_ENGINE_SESSION_T *session,
+                                         uint32_t now_ms) {
+  if ((int32_t)(session->end_time_ms - now_ms) > 0) {
+    session->remaining_ms = session->end_time_ms - now_ms;
+  } else {
+    session->remaining_ms = 0; // Already expired
+  }
+}
+
+static inline void
+POMODORO_ENGINE_FN(restore_remaining_time)(POMODORO_ENGINE_SESSION_T *session,
+                                           uint32_t now_ms) {
+  session->end_time_ms = now_ms + session->remaining_ms;
+  session->remaining_ms = 0;
+}
+
+static inline void
+POMODORO_ENGINE_FN(zero_time_fields)(POMODORO_ENGINE_SESSION_T *session) {
+  session->end_time_ms = 0;
+  session->remaining_ms = 0;
+}
+
+static inline void
+POMODORO_ENGINE_FN(reset)(POMODORO_ENGINE_SESSION_T *session) {
+  session->state = POMODORO_STATE_IDLE;
+
+  // Phases
+  session->phase_index = 0;
+
+  // Timing
+  POMODORO_ENGINE_FN(zero_time_fields)(session);
+}
+
+/*
+ * @brief Effects for entering RUNNING with `remaining_ms` left of the current
+ * phase: every pending deadline is replaced by the phase end and the reminders
+ * that are still ahead. `extra` (optional) is appended.
+ */
+static inline void
+POMODORO_ENGINE_FN(set_running_effects)(
+    pomodoro_effects_t *effects, const POMODORO_ENGINE_SESSION_T *session,
+    uint32_t remaining_ms, const pomodoro_effect_t *extra) {
+  const uint32_t half_duration_ms =
+      POMODORO_ENGINE_CURRENT_DURATION_MS(session) / 2;
+
+  pomodoro_effect_t effects_array[MAX_EFFECTS];
+  uint32_t count = 0;
+
+  effects_array[count++] = POMODORO_ENGINE_STOP_ALL_TIMERS;
+  effects_array[count++] =
+      pomodoro_engine_timer_start(POMODORO_TIMER_PHASE_END, remaining_ms);
+  if (remaining_ms > POMODORO_WARNING_LEAD_MS) {
+    effects_array[count++] = pomodoro_engine_timer_start(
+        POMODORO_TIMER_WARNING, remaining_ms - POMODORO_WARNING_LEAD_MS);
+  }
+  if (remaining_ms > half_duration_ms) {
+    effects_array[count++] = pomodoro_engine_timer_start(
+        POMODORO_TIMER_HALFWAY, remaining_ms - half_duration_ms);
+  }
+  if (extra != NULL) {
+    effects_array[count++] = *extra;
+  }
+
+  pomodoro_engine_effects_set(effects, effects_array, count);
+}
+
+// SKIP and TIMEOUT: the next phase, or FINISHED after the last one
+POMODORO_ENGINE_ALWAYS_INLINE void
+POMODORO_ENGINE_FN(next_phase)(POMODORO_ENGINE_SESSION_T *session,
+                               uint32_t now_ms, pomodoro_effects_t *effects) {
+  if (POMODORO_ENGINE_FN(has_next_phase)(session)) {
+    session->state = POMODORO_STATE_RUNNING;
+    POMODORO_ENGINE_FN(advance_phase)(session, now_ms);
+    const pomodoro_effect_t phase_changed = {
+        .type = POMODORO_EFFECT_PHASE_CHANGED,
+        .phase_changed.phase_index = session->phase_index,
+    };
+    POMODORO_ENGINE_FN(set_running_effects)(
+        effects, session, POMODORO_ENGINE_CURRENT_DURATION_MS(session),
+        &phase_changed);
+  } else {
+    session->state = POMODORO_STATE_FINISHED;
+    POMODORO_ENGINE_FN(zero_time_fields)(session);
+    pomodoro_engine_effects_set(effects,
+                                (pomodoro_effect_t[]){
+                                    POMODORO_ENGINE_STOP_ALL_TIMERS,
+                                    {.type = POMODORO_EFFECT_SESSION_FINISHED},
+                                },
+                                2);
+  }
+}
+
+static inline void
+POMODORO_ENGINE_FN(set_reminder)(pomodoro_effects_t *effects,
+                                 pomodoro_timer_id_t id) {
+  pomodoro_engine_effects_set(effects,
+                              (pomodoro_effect_t[]){
+                                  {
+                                      .type = POMODORO_EFFECT_REMINDER,
+                                      .reminder.timer_id = id,
+                                  },
+                              },
+                              1);
+}
+
+static inline pomodoro_err_t
+POMODORO_ENGINE_FN(dispatch)(POMODORO_ENGINE_SESSION_T *session,
+                             const pomodoro_event_t event,
+                             const uint32_t now_ms,
+                             pomodoro_effects_t *effects) {
+  uint32_t remaining_ms;
+
+  // Clear effects
+  effects->count = 0;
+
+  // Process events
+  switch (POMODORO_ENGINE_KEY(session->state, event)) {
+
+  // restart event
+  case (POMODORO_ENGINE_KEY(POMODORO_STATE_IDLE, POMODORO_EVT_RESTART)):
+  case (POMODORO_ENGINE_KEY(POMODORO_STATE_RUNNING, POMODORO_EVT_RESTART)):
+  case (POMODORO_ENGINE_KEY(POMODORO_STATE_PAUSED, POMODORO_EVT_RESTART)):
+  case (POMODORO_ENGINE_KEY(POMODORO_STATE_FINISHED, POMODORO_EVT_RESTART)):
+    POMODORO_ENGINE_FN(reset)(session);
+    pomodoro_engine_effects_set(effects, &POMODORO_ENGINE_STOP_ALL_TIMERS, 1);
+    break;
+
+  // IDLE
+  case POMODORO_ENGINE_KEY(POMODORO_STATE_IDLE, POMODORO_EVT_START):
+    session->state = POMODORO_STATE_RUNNING;
+    POMODORO_ENGINE_FN(set_end_time_current_phase)(session, now_ms);
+    remaining_ms = POMODORO_ENGINE_CURRENT_DURATION_MS(session);
+    POMODORO_ENGINE_FN(set_running_effects)(effects, session, remaining_ms,
+                                            NULL);
+    break;
+
+  // RUNNING
+  case POMODORO_ENGINE_KEY(POMODORO_STATE_RUNNING, POMODORO_EVT_PAUSE):
+    session->state = POMODORO_STATE_PAUSED;
+    POMODORO_ENGINE_FN(store_remaining_time)(session, now_ms);
+    pomodoro_engine_effects_set(
+        effects,
+        (pomodoro_effect_t[]){
+            POMODORO_ENGINE_STOP_ALL_TIMERS,
+            pomodoro_engine_timer_start(POMODORO_TIMER_PAUSE_REMINDER,
+                                        POMODORO_PAUSE_REMINDER_MS),
+        },
+        2);
+    break;
+  case POMODORO_ENGINE_KEY(POMODORO_STATE_RUNNING, POMODORO_EVT_SKIP):
+  case POMODORO_ENGINE_KEY(POMODORO_STATE_RUNNING, POMODORO_EVT_TIMEOUT):
+    POMODORO_ENGINE_FN(next_phase)(session, now_ms, effects);
+    break;
+  case POMODORO_ENGINE_KEY(POMODORO_STATE_RUNNING, POMODORO_EVT_WARNING):
+    POMODORO_ENGINE_FN(set_reminder)(effects, POMODORO_TIMER_WARNING);
+    return POMODORO_STATUS_OK; // The session is unchanged
+  case POMODORO_ENGINE_KEY(POMODORO_STATE_RUNNING, POMODORO_EVT_HALFWAY):
+    POMODORO_ENGINE_FN(set_reminder)(effects, POMODORO_TIMER_HALFWAY);
+    return POMODORO_STATUS_OK;
+
+  // PAUSED
+  case (POMODORO_ENGINE_KEY(POMODORO_STATE_PAUSED, POMODORO_EVT_RESUME)):
+    session->state = POMODORO_STATE_RUNNING;
+    remaining_ms = session->remaining_ms;
+    POMODORO_ENGINE_FN(restore_remaining_time)(session, now_ms);
+    POMODORO_ENGINE_FN(set_running_effects)(effects, session, remaining_ms,
+                                            NULL);
+    break;
+  case (POMODORO_ENGINE_KEY(POMODORO_STATE_PAUSED, POMODORO_EVT_SKIP)):
+    POMODORO_ENGINE_FN(next_phase)(session, now_ms, effects);
+    break;
+  case (POMODORO_ENGINE_KEY(POMODORO_STATE_PAUSED,
+                            POMODORO_EVT_PAUSE_REMINDER)):
+    POMODORO_ENGINE_FN(set_reminder)(effects, POMODORO_TIMER_PAUSE_REMINDER);
+    return POMODORO_STATUS_OK;
+  case (POMODORO_ENGINE_KEY(POMODORO_STATE_PAUSED, POMODORO_EVT_TIMEOUT)):
+    return POMODORO_STATUS_ILLEGAL_TRANSITION;
+
+  // FINISHED
+  case (POMODORO_ENGINE_KEY(POMODORO_STATE_FINISHED, POMODORO_EVT_TIMEOUT)):
+    return POMODORO_STATUS_ILLEGAL_TRANSITION;
+
+  // Ignore all other transitions, including reminders that were already in
+  // the queue when their deadline got cancelled
+  default:
+    return POMODORO_STATUS_INVALID_TRANSITION;
+  }
+
+  // At most 5 effects so far, see set_running_effects()
+  effects->effects[effects->count++] = (pomodoro_effect_t){
+      .type = POMODORO_EFFECT_SESSION_UPDATED,
+      .session_updated.state = (pomodoro_state_t)session->state,
+  };
+  return POMODORO_STATUS_OK;
+}
+
+#undef POMODORO_ENGINE_CURRENT_DURATION_MS
+#undef POMODORO_ENGINE_FN
+#undef POMODORO_ENGINE_SESSION_T
+#undef POMODORO_ENGINE_PHASE_COUNT
+#undef POMODORO_ENGINE_DURATION_MS
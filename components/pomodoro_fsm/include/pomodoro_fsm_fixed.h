@@ -0,0 +1,135 @@
+/*
+ * @brief FSM specialized for a schedule known at compile time.
+ *
+ * Same transitions and effects as pomodoro_session_dispatch(), but the phase
+ * count and durations are constants folded into the code: the session has no
+ * config pointer and dispatch has no runtime checks. Define the schedule as
+ * an X-macro and a prefix, then include this header:
+ *
+ *   #define POMODORO_FIXED_PREFIX focus
+ *   #define POMODORO_FIXED_SCHEDULE(PHASE)                                    \
+ *     PHASE("Work", 25 * 60 * 1000, true)                                     \
+ *     PHASE("Rest", 5 * 60 * 1000, false)
+ *   #include "pomodoro_fsm_fixed.h"
+ *
+ * `PHASE(name, duration_ms, focus)` takes the fields of pomodoro_phase_t. For
+ * the prefix `focus`, this generates (all `static`):
+ * - focus_session_t
+ * - focus_config: the schedule as a pomodoro_config_t
+ * - focus_session_initialize(session, effects)
+ * - focus_session_dispatch(session, event, now_ms, effects)
+ * - focus_current_phase(session)
+ * - focus_time_remaining_ms(session, now_ms)
+ * - focus_session_expand(session, out): a pomodoro_session_t view, for code
+ *   written against the generic FSM (statistics, live state, ...)
+ *
+ * Both macros are undefined at the end, so a translation unit may include
+ * this header once per schedule.
+ */
+#include "pomodoro_fsm.h"
+#include <stdint.h>
+
+#if !defined(POMODORO_FIXED_PREFIX) || !defined(POMODORO_FIXED_SCHEDULE)
+#error "Define POMODORO_FIXED_PREFIX and POMODORO_FIXED_SCHEDULE first"
+#endif
+
+#ifndef POMODORO_FSM_FIXED_COMMON
+#define POMODORO_FSM_FIXED_COMMON
+
+#define POMODORO_FIXED_CONCAT_(prefix, name) prefix##_##name
+#define POMODORO_FIXED_CONCAT(prefix, name)                                    \
+  POMODORO_FIXED_CONCAT_(prefix, name)
+
+#define POMODORO_FIXED_AS_PHASE(phase_name, phase_duration_ms, phase_focus)    \
+  {.name = phase_name, .duration_ms = phase_duration_ms, .focus = phase_focus},
+#define POMODORO_FIXED_AS_DURATION(phase_name, phase_duration_ms, phase_focus) \
+  phase_duration_ms,
+
+#endif // POMODORO_FSM_FIXED_COMMON
+
+#define POMODORO_FIXED_FN(name)                                                \
+  POMODORO_FIXED_CONCAT(POMODORO_FIXED_PREFIX, name)
+
+static const uint32_t POMODORO_FIXED_FN(durations_ms)[] = {
+    POMODORO_FIXED_SCHEDULE(POMODORO_FIXED_AS_DURATION)};
+
+#define POMODORO_FIXED_COUNT                                                   \
+  (sizeof(POMODORO_FIXED_FN(durations_ms)) /                                   \
+   sizeof(POMODORO_FIXED_FN(durations_ms)[0]))
+
+_Static_assert(POMODORO_FIXED_COUNT <= MAX_PHASES,
+               "Fixed schedule has more than MAX_PHASES phases");
+
+// Only ends up in the image if something uses it
+__attribute__((unused)) static const pomodoro_config_t POMODORO_FIXED_FN(
+    config) = {
+    .phases = {POMODORO_FIXED_SCHEDULE(POMODORO_FIXED_AS_PHASE)},
+    .count = POMODORO_FIXED_COUNT,
+};
+
+typedef struct POMODORO_FIXED_FN(session) {
+  // Current state, a pomodoro_state_t
+  uint8_t state;
+  uint8_t phase_index;
+  // Timing
+  uint32_t end_time_ms;
+  uint32_t remaining_ms;
+} POMODORO_FIXED_FN(session_t);
+
+#define POMODORO_ENGINE_FN(name) POMODORO_FIXED_FN(engine_##name)
+#define POMODORO_ENGINE_SESSION_T POMODORO_FIXED_FN(session_t)
+#define POMODORO_ENGINE_PHASE_COUNT(session) POMODORO_FIXED_COUNT
+#define POMODORO_ENGINE_DURATION_MS(session, index)                            \
+  (POMODORO_FIXED_FN(durations_ms)[index])
+#include "pomodoro_fsm_engine.h"
+
+static inline void
+POMODORO_FIXED_FN(session_initialize)(POMODORO_FIXED_FN(session_t) * session,
+                                      pomodoro_effects_t *effects) {
+  POMODORO_FIXED_FN(engine_reset)(session);
+  effects->count = 0;
+}
+
+/*
+ * @brief pomodoro_session_dispatch() for this schedule. The session is assumed
+ * valid, only the event is checked.
+ */
+static inline pomodoro_err_t
+POMODORO_FIXED_FN(session_dispatch)(POMODORO_FIXED_FN(session_t) * session,
+                                    pomodoro_event_t event, uint32_t now_ms,
+                                    pomodoro_effects_t *effects) {
+  if (event >= POMODORO_EVT_COUNT) {
+    return POMODORO_STATUS_INVALID_ARGUMENTS;
+  }
+
+  return POMODORO_FIXED_FN(engine_dispatch)(session, event, now_ms, effects);
+}
+
+static inline const pomodoro_phase_t *POMODORO_FIXED_FN(current_phase)(
+    const POMODORO_FIXED_FN(session_t) * session) {
+  return &POMODORO_FIXED_FN(config).phases[session->phase_index];
+}
+
+static inline void
+POMODORO_FIXED_FN(session_expand)(const POMODORO_FIXED_FN(session_t) * session,
+                                  pomodoro_session_t *out) {
+  *out = (pomodoro_session_t){
+      .state = (pomodoro_state_t)session->state,
+      .config = &POMODORO_FIXED_FN(config),
+      .phase_index = session->phase_index,
+      .end_time_ms = session->end_time_ms,
+      .remaining_ms = session->remaining_ms,
+  };
+}
+
+static inline uint32_t POMODORO_FIXED_FN(time_remaining_ms)(
+    const POMODORO_FIXED_FN(session_t) * session, uint32_t now_ms) {
+  pomodoro_session_t expanded;
+  POMODORO_FIXED_FN(session_expand)(session, &expanded);
+  return pomodoro_time_remaining_ms(&expanded, now_ms);
+}
+
+#undef POMODORO_FIXED_COUNT
+#undef POMODORO_FIXED_FN
+#undef POMODORO_FIXED_PREFIX
+#undef POMODORO_FIXED_SCHEDULE
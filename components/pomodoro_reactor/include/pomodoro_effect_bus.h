@@ -0,0 +1,57 @@
+#ifndef POMODORO_EFFECT_BUS_H
+#define POMODORO_EFFECT_BUS_H
+
+#include "pomodoro_fsm.h"
+#include <stdint.h>
+
+#define POMODORO_EFFECT_MASK(type) (1u << (type))
+#define POMODORO_EFFECT_MASK_ALL ((1u << POMODORO_EFFECT_TYPE_COUNT) - 1)
+
+// Handlers that can subscribe to the same effect type
+#define MAX_EFFECT_HANDLERS 6
+
+/*
+ * @brief Effect handler. The effect is owned by the reactor and only valid for
+ * the duration of the call.
+ */
+typedef void (*pomodoro_effect_handler_fn)(void *ctx,
+                                           const pomodoro_effect_t *effect);
+
+typedef struct pomodoro_effect_handler {
+  pomodoro_effect_handler_fn handle;
+  void *ctx;
+} pomodoro_effect_handler_t;
+
+/*
+ * @brief Fans effects out to the handlers subscribed to their type.
+ *
+ * Subscriptions are resolved once, at registration time, into a per-type
+ * table. Dispatching an effect only visits the handlers of its own type, so
+ * adding a handler for one type costs nothing to the others.
+ */
+typedef struct pomodoro_effect_bus {
+  pomodoro_effect_handler_t handlers[POMODORO_EFFECT_TYPE_COUNT]
+                                    [MAX_EFFECT_HANDLERS];
+  uint8_t handler_count[POMODORO_EFFECT_TYPE_COUNT];
+} pomodoro_effect_bus_t;
+
+void pomodoro_effect_bus_initialize(pomodoro_effect_bus_t *bus);
+
+/*
+ * @brief Subscribes `handle` to every effect type in `type_mask`.
+ *
+ * Registration is all-or-nothing: if any of the requested types is already at
+ * MAX_EFFECT_HANDLERS, nothing is registered.
+ *
+ * @return POMODORO_STATUS_INVALID_ARGUMENTS on an empty or unknown mask, or
+ * when a per-type table is full.
+ */
+pomodoro_err_t pomodoro_effect_bus_register(pomodoro_effect_bus_t *bus,
+                                            uint32_t type_mask,
+                                            pomodoro_effect_handler_fn handle,
+                                            void *ctx);
+
+void pomodoro_effect_bus_dispatch(const pomodoro_effect_bus_t *bus,
+                                  const pomodoro_effects_t *effects);
+
+#endif // POMODORO_EFFECT_BUS_H
@@ -0,0 +1,40 @@
+#ifndef POMODORO_LATENCY_H
+#define POMODORO_LATENCY_H
+
+#include <stdint.h>
+
+/*
+ * @brief Running min/max/average of a duration, in microseconds
+ */
+typedef struct pomodoro_latency {
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t total_us;
+} pomodoro_latency_t;
+
+static inline void pomodoro_latency_reset(pomodoro_latency_t *latency) {
+  latency->count = 0;
+  latency->min_us = UINT32_MAX;
+  latency->max_us = 0;
+  latency->total_us = 0;
+}
+
+static inline void pomodoro_latency_add(pomodoro_latency_t *latency,
+                                        uint32_t duration_us) {
+  latency->count++;
+  latency->total_us += duration_us;
+  if (duration_us < latency->min_us) {
+    latency->min_us = duration_us;
+  }
+  if (duration_us > latency->max_us) {
+    latency->max_us = duration_us;
+  }
+}
+
+static inline uint32_t
+pomodoro_latency_average_us(const pomodoro_latency_t *latency) {
+  return latency->count ? (uint32_t)(latency->total_us / latency->count) : 0;
+}
+
+#endif // POMODORO_LATENCY_H
@@ -0,0 +1,61 @@
+#ifndef POMODORO_QUERY_H
+#define POMODORO_QUERY_H
+
+#include "pomodoro_fsm.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+// A consistent view of the session, as returned by `pomodoro_query_state`
+typedef struct pomodoro_live_state {
+  pomodoro_state_t state;
+  uint32_t phase_index;
+  const char *phase_name; // Points into the session config
+  uint32_t end_time_ms;   // Only meaningful while RUNNING
+  uint32_t remaining_ms;  // At the `now_ms` passed to the query
+  uint32_t generation;    // Publications so far, to tell updates apart
+} pomodoro_live_state_t;
+
+// Fields are atomics so that a read racing a write is not a data race
+typedef struct pomodoro_query_slot {
+  atomic_uint_fast32_t state;
+  atomic_uint_fast32_t phase_index;
+  atomic_uint_fast32_t end_time_ms;
+  atomic_uint_fast32_t remaining_ms;
+} pomodoro_query_slot_t;
+
+/*
+ * @brief Session state published by the reactor for any other task to read.
+ *
+ * Two slots and a generation counter: the reactor writes the slot readers are
+ * not pointed at, then bumps `generation` to flip them over. A reader copies
+ * the slot of the generation it saw and retries if the generation moved in the
+ * meantime, so it never returns a mix of two publications.
+ *
+ * Neither side blocks or takes a lock. The single writer never waits, and a
+ * reader only retries when a whole publication completed during its copy,
+ * i.e. at most once per reactor dispatch. A reader that preempts the reactor
+ * halfway through a write is not affected, as that slot is not the current
+ * one.
+ */
+typedef struct pomodoro_query {
+  const pomodoro_config_t *config;
+  atomic_uint_fast32_t generation;
+  pomodoro_query_slot_t slots[2];
+} pomodoro_query_t;
+
+void pomodoro_query_initialize(pomodoro_query_t *query,
+                               const pomodoro_session_t *session);
+
+/*
+ * @brief Publishes `session`. Must only be called from one task, the reactor.
+ */
+void pomodoro_query_publish(pomodoro_query_t *query,
+                            const pomodoro_session_t *session);
+
+/*
+ * @brief Reads the latest publication. Safe from any task, never blocks.
+ */
+void pomodoro_query_state(const pomodoro_query_t *query, uint32_t now_ms,
+                          pomodoro_live_state_t *out);
+
+#endif // POMODORO_QUERY_H
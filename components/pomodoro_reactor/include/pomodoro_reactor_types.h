@@ -2,6 +2,8 @@
 #define POMODORO_REACTOR_TYPES_H
 
 #include "pomodoro_fsm.h"
+#include <stdbool.h>
+#include <stdint.h>
 
 typedef enum reactor_event_type {
   REACTOR_FSM_EVENT,
@@ -10,10 +12,23 @@ typedef enum reactor_event_type {
 
 typedef enum ui_event_type {
   UI_EVT_STATUS,
+  UI_EVT_DUMP_RECORDING,
+  UI_EVT_LATENCY,
+  UI_EVT_STATS,
+  UI_EVT_TELEMETRY_TEXT,
+  UI_EVT_TELEMETRY_BINARY_1HZ,
+  UI_EVT_TELEMETRY_BINARY_4HZ,
+  UI_EVT_TELEMETRY_BINARY_10HZ,
+
+  // MUST BE LAST: Used for getting the count
+  UI_EVT_COUNT,
 } ui_event_type_t;
 
 typedef struct timestamped_event {
-  reactor_event_type_t type;
+  uint8_t type; // reactor_event_type_t
+  // Generation of the deadline that produced this event, 0 if it does not
+  // come from pomodoro_timer. See pomodoro_timer_is_current().
+  uint16_t timer_generation;
   uint32_t timestamp_ms;
   union {
     ui_event_type_t ui_event;
@@ -21,4 +36,92 @@ typedef struct timestamped_event {
   } data;
 } timestamped_event_t;
 
+#define MAX_BATCH_EVENTS 8
+
+// Compact form of a FSM or UI event inside a batch
+typedef struct reactor_batch_item {
+  uint8_t type;    // reactor_event_type_t
+  uint8_t payload; // pomodoro_event_t or ui_event_type_t
+} reactor_batch_item_t;
+
+/*
+ * @brief Several FSM/UI events processed back-to-back, with one timestamp.
+ *
+ * Batches travel on their own queue, so that single events (and the records
+ * kept of them) do not pay for the batch's size.
+ */
+typedef struct reactor_batch {
+  uint32_t timestamp_ms;
+  uint8_t count;
+  reactor_batch_item_t items[MAX_BATCH_EVENTS];
+} reactor_batch_t;
+
+static inline void reactor_batch_initialize(reactor_batch_t *batch,
+                                            uint32_t timestamp_ms) {
+  batch->timestamp_ms = timestamp_ms;
+  batch->count = 0;
+}
+
+/*
+ * @brief Appends a FSM or UI event to `batch`.
+ *
+ * @return false if the batch is already full.
+ */
+static inline bool reactor_batch_append(reactor_batch_t *batch,
+                                        const timestamped_event_t *event) {
+  if (batch->count >= MAX_BATCH_EVENTS) {
+    return false;
+  }
+
+  batch->items[batch->count++] = (reactor_batch_item_t){
+      .type = (uint8_t)event->type,
+      .payload = (uint8_t)(event->type == REACTOR_FSM_EVENT
+                               ? event->data.fsm_event
+                               : event->data.ui_event),
+  };
+  return true;
+}
+
+/*
+ * @brief Appends the contents of `other` to `batch`.
+ *
+ * @return false if the batch would exceed MAX_BATCH_EVENTS; `batch` is left
+ * unchanged in that case.
+ */
+static inline bool reactor_batch_append_batch(reactor_batch_t *batch,
+                                              const reactor_batch_t *other) {
+  if (batch->count + other->count > MAX_BATCH_EVENTS) {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < other->count; i++) {
+    batch->items[batch->count++] = other->items[i];
+  }
+  return true;
+}
+
+/*
+ * @brief Expands `batch` into plain FSM/UI events sharing its timestamp.
+ *
+ * @return number of events written to `out`.
+ */
+static inline uint32_t
+reactor_batch_unpack(const reactor_batch_t *batch,
+                     timestamped_event_t out[MAX_BATCH_EVENTS]) {
+  uint32_t count = 0;
+  for (uint8_t i = 0; i < batch->count && i < MAX_BATCH_EVENTS; i++) {
+    const reactor_batch_item_t *item = &batch->items[i];
+    out[count].type = item->type;
+    out[count].timer_generation = 0;
+    out[count].timestamp_ms = batch->timestamp_ms;
+    if (item->type == REACTOR_FSM_EVENT) {
+      out[count].data.fsm_event = (pomodoro_event_t)item->payload;
+    } else {
+      out[count].data.ui_event = (ui_event_type_t)item->payload;
+    }
+    count++;
+  }
+  return count;
+}
+
 #endif // POMODORO_REACTOR_TYPES_H
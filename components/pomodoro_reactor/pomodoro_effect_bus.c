@@ -0,0 +1,55 @@
+#include "pomodoro_effect_bus.h"
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+void pomodoro_effect_bus_initialize(pomodoro_effect_bus_t *bus) {
+  assert(bus != NULL);
+  memset(bus, 0, sizeof(*bus));
+}
+
+pomodoro_err_t pomodoro_effect_bus_register(pomodoro_effect_bus_t *bus,
+                                            uint32_t type_mask,
+                                            pomodoro_effect_handler_fn handle,
+                                            void *ctx) {
+  if (bus == NULL || handle == NULL || type_mask == 0 ||
+      (type_mask & ~POMODORO_EFFECT_MASK_ALL) != 0) {
+    return POMODORO_STATUS_INVALID_ARGUMENTS;
+  }
+
+  // Check every table first so that a failure leaves the bus untouched
+  for (uint32_t type = 0; type < POMODORO_EFFECT_TYPE_COUNT; type++) {
+    if ((type_mask & POMODORO_EFFECT_MASK(type)) &&
+        bus->handler_count[type] >= MAX_EFFECT_HANDLERS) {
+      return POMODORO_STATUS_INVALID_ARGUMENTS;
+    }
+  }
+
+  for (uint32_t type = 0; type < POMODORO_EFFECT_TYPE_COUNT; type++) {
+    if (type_mask & POMODORO_EFFECT_MASK(type)) {
+      bus->handlers[type][bus->handler_count[type]++] =
+          (pomodoro_effect_handler_t){.handle = handle, .ctx = ctx};
+    }
+  }
+
+  return POMODORO_STATUS_OK;
+}
+
+void pomodoro_effect_bus_dispatch(const pomodoro_effect_bus_t *bus,
+                                  const pomodoro_effects_t *effects) {
+  assert(bus != NULL);
+  assert(effects != NULL);
+
+  for (uint32_t i = 0; i < effects->count; i++) {
+    const pomodoro_effect_t *effect = &effects->effects[i];
+
+    if (effect->type >= POMODORO_EFFECT_TYPE_COUNT) {
+      continue;
+    }
+
+    const pomodoro_effect_handler_t *handlers = bus->handlers[effect->type];
+    for (uint32_t h = 0; h < bus->handler_count[effect->type]; h++) {
+      handlers[h].handle(handlers[h].ctx, effect);
+    }
+  }
+}
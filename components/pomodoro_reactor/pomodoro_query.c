@@ -0,0 +1,76 @@
+#include "pomodoro_query.h"
+#include <assert.h>
+#include <stddef.h>
+
+static void write_slot(pomodoro_query_slot_t *slot,
+                       const pomodoro_session_t *session) {
+  atomic_store_explicit(&slot->state, session->state, memory_order_relaxed);
+  atomic_store_explicit(&slot->phase_index, session->phase_index,
+                        memory_order_relaxed);
+  atomic_store_explicit(&slot->end_time_ms, session->end_time_ms,
+                        memory_order_relaxed);
+  atomic_store_explicit(&slot->remaining_ms, session->remaining_ms,
+                        memory_order_relaxed);
+}
+
+void pomodoro_query_initialize(pomodoro_query_t *query,
+                               const pomodoro_session_t *session) {
+  // Sanity checks
+  assert(query != NULL);
+  assert(session != NULL);
+
+  query->config = session->config;
+  atomic_init(&query->generation, 0);
+  for (uint32_t i = 0; i < 2; i++) {
+    write_slot(&query->slots[i], session);
+  }
+}
+
+void pomodoro_query_publish(pomodoro_query_t *query,
+                            const pomodoro_session_t *session) {
+  uint32_t generation =
+      atomic_load_explicit(&query->generation, memory_order_relaxed);
+
+  // Orders the previous flip before the writes below: a reader that sees any
+  // of them also sees that its slot is no longer current
+  atomic_thread_fence(memory_order_release);
+  write_slot(&query->slots[(generation + 1) & 1], session);
+
+  atomic_store_explicit(&query->generation, generation + 1,
+                        memory_order_release);
+}
+
+void pomodoro_query_state(const pomodoro_query_t *query, uint32_t now_ms,
+                          pomodoro_live_state_t *out) {
+  pomodoro_session_t copy = {.config = query->config};
+  uint32_t generation;
+
+  while (true) {
+    generation = atomic_load_explicit(&query->generation, memory_order_acquire);
+    const pomodoro_query_slot_t *slot = &query->slots[generation & 1];
+
+    copy.state = (pomodoro_state_t)atomic_load_explicit(&slot->state,
+                                                        memory_order_relaxed);
+    copy.phase_index =
+        atomic_load_explicit(&slot->phase_index, memory_order_relaxed);
+    copy.end_time_ms =
+        atomic_load_explicit(&slot->end_time_ms, memory_order_relaxed);
+    copy.remaining_ms =
+        atomic_load_explicit(&slot->remaining_ms, memory_order_relaxed);
+
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&query->generation, memory_order_relaxed) ==
+        generation) {
+      break;
+    }
+  }
+
+  *out = (pomodoro_live_state_t){
+      .state = copy.state,
+      .phase_index = copy.phase_index,
+      .phase_name = pomodoro_current_phase(&copy)->name,
+      .end_time_ms = copy.end_time_ms,
+      .remaining_ms = pomodoro_time_remaining_ms(&copy, now_ms),
+      .generation = generation,
+  };
+}
@@ -0,0 +1,63 @@
+#ifndef POMODORO_RECORDER_H
+#define POMODORO_RECORDER_H
+
+#include "pomodoro_fsm.h"
+#include "pomodoro_reactor_types.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define POMODORO_RECORDER_CAPACITY 128
+
+typedef struct pomodoro_record {
+  timestamped_event_t event;
+  pomodoro_err_t result;
+} pomodoro_record_t;
+
+/*
+ * @brief Fixed-size ring buffer of every event the reactor processed, together
+ * with the result of dispatching it.
+ *
+ * When the ring is full the oldest record is evicted and re-applied to `base`,
+ * a shadow session that always holds the state *before* the oldest retained
+ * record. A dump therefore contains everything a replay needs to start from:
+ * the schedule, the base session and the records.
+ */
+typedef struct pomodoro_recorder {
+  pomodoro_record_t records[POMODORO_RECORDER_CAPACITY];
+  uint32_t head;  // Index of the oldest record
+  uint32_t count; // Records currently retained
+  uint32_t evicted;
+  pomodoro_session_t base;
+  pomodoro_effects_t base_effects; // Scratch space, never read
+} pomodoro_recorder_t;
+
+void pomodoro_recorder_initialize(pomodoro_recorder_t *recorder,
+                                  const pomodoro_session_t *initial_session);
+
+void pomodoro_recorder_append(pomodoro_recorder_t *recorder,
+                              const timestamped_event_t *event,
+                              pomodoro_err_t result);
+
+/*
+ * @brief Returns the `index`-th retained record, oldest first, or NULL when out
+ * of range.
+ */
+const pomodoro_record_t *
+pomodoro_recorder_get(const pomodoro_recorder_t *recorder, uint32_t index);
+
+/*
+ * @brief Writes the recording as line-oriented text:
+ *
+ *   REC-BEGIN v1 phases=<n> records=<n> evicted=<n>
+ *   REC-PHASE <index> <name> <duration_ms> <focus>
+ *   REC-BASE <state> <phase_index> <end_time_ms> <remaining_ms>
+ *   REC <type> <timestamp_ms> <payload> <result>
+ *   REC-END
+ *
+ * Phase names are written verbatim and must not contain whitespace. `focus`
+ * is 0 or 1.
+ */
+void pomodoro_recorder_dump(const pomodoro_recorder_t *recorder, FILE *out);
+
+#endif // POMODORO_RECORDER_H
@@ -0,0 +1,98 @@
+#include "pomodoro_recorder.h"
+#include <assert.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+void pomodoro_recorder_initialize(pomodoro_recorder_t *recorder,
+                                  const pomodoro_session_t *initial_session) {
+  // Sanity checks
+  assert(recorder != NULL);
+  assert(initial_session != NULL);
+
+  recorder->head = 0;
+  recorder->count = 0;
+  recorder->evicted = 0;
+  memcpy(&recorder->base, initial_session, sizeof(pomodoro_session_t));
+  pomodoro_effects_clear(&recorder->base_effects);
+}
+
+static void evict_oldest(pomodoro_recorder_t *recorder) {
+  const pomodoro_record_t *oldest = &recorder->records[recorder->head];
+
+  // Keep `base` in sync with the first record that is still retained
+  if (oldest->event.type == REACTOR_FSM_EVENT) {
+    pomodoro_session_dispatch(&recorder->base, oldest->event.data.fsm_event,
+                              oldest->event.timestamp_ms,
+                              &recorder->base_effects);
+  }
+
+  recorder->head = (recorder->head + 1) % POMODORO_RECORDER_CAPACITY;
+  recorder->count--;
+  recorder->evicted++;
+}
+
+void pomodoro_recorder_append(pomodoro_recorder_t *recorder,
+                              const timestamped_event_t *event,
+                              pomodoro_err_t result) {
+  assert(recorder != NULL);
+  assert(event != NULL);
+
+  if (recorder->count == POMODORO_RECORDER_CAPACITY) {
+    evict_oldest(recorder);
+  }
+
+  uint32_t tail =
+      (recorder->head + recorder->count) % POMODORO_RECORDER_CAPACITY;
+  recorder->records[tail].event = *event;
+  recorder->records[tail].result = result;
+  recorder->count++;
+}
+
+const pomodoro_record_t *
+pomodoro_recorder_get(const pomodoro_recorder_t *recorder, uint32_t index) {
+  if (recorder == NULL || index >= recorder->count) {
+    return NULL;
+  }
+  return &recorder
+              ->records[(recorder->head + index) % POMODORO_RECORDER_CAPACITY];
+}
+
+static uint32_t record_payload(const timestamped_event_t *event) {
+  switch (event->type) {
+  case REACTOR_FSM_EVENT:
+    return (uint32_t)event->data.fsm_event;
+  case REACTOR_UI_EVENT:
+    return (uint32_t)event->data.ui_event;
+  default:
+    return 0;
+  }
+}
+
+void pomodoro_recorder_dump(const pomodoro_recorder_t *recorder, FILE *out) {
+  const pomodoro_config_t *config = recorder->base.config;
+
+  fprintf(out, "REC-BEGIN v1 phases=%" PRIu32 " records=%" PRIu32
+               " evicted=%" PRIu32 "\n",
+          config->count, recorder->count, recorder->evicted);
+
+  for (uint32_t i = 0; i < config->count; i++) {
+    fprintf(out, "REC-PHASE %" PRIu32 " %s %" PRIu32 " %d\n", i,
+            config->phases[i].name, config->phases[i].duration_ms,
+            config->phases[i].focus ? 1 : 0);
+  }
+
+  const pomodoro_session_t *base = &recorder->base;
+  fprintf(out, "REC-BASE %d %" PRIu32 " %" PRIu32 " %" PRIu32 "\n",
+          (int)base->state, base->phase_index, base->end_time_ms,
+          base->remaining_ms);
+
+  for (uint32_t i = 0; i < recorder->count; i++) {
+    const pomodoro_record_t *record = pomodoro_recorder_get(recorder, i);
+    fprintf(out, "REC %d %" PRIu32 " %" PRIu32 " %d\n",
+            (int)record->event.type, record->event.timestamp_ms,
+            record_payload(&record->event), (int)record->result);
+  }
+
+  fprintf(out, "REC-END\n");
+}
@@ -0,0 +1,161 @@
+#ifndef POMODORO_REPLAY_H
+#define POMODORO_REPLAY_H
+
+#include "pomodoro_fsm.h"
+#include "pomodoro_reactor_types.h"
+#include "pomodoro_recorder.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * @brief Stand-in for `pomodoro_timer` that lives on the virtual clock.
+ *
+ * Instead of arming a hardware timer it only remembers one deadline per timer
+ * id, which the replay engine turns into the matching event (TIMEOUT, WARNING,
+ * ...) when the clock gets there.
+ */
+typedef struct pomodoro_sim_timer {
+  bool armed[POMODORO_TIMER_COUNT];
+  uint32_t deadline_ms[POMODORO_TIMER_COUNT];
+} pomodoro_sim_timer_t;
+
+void pomodoro_sim_timer_handle_effects(pomodoro_sim_timer_t *timer,
+                                       const pomodoro_effects_t *effects,
+                                       uint32_t now_ms);
+
+/*
+ * @brief Finds the earliest armed deadline.
+ *
+ * @return false if no timer is armed.
+ */
+bool pomodoro_sim_timer_next(const pomodoro_sim_timer_t *timer,
+                             pomodoro_timer_id_t *timer_id);
+
+typedef enum pomodoro_replay_timeouts {
+  // Timer events are taken from the source, exactly as they were recorded
+  POMODORO_REPLAY_TIMEOUTS_RECORDED = 0,
+  // Timer events are generated by the simulated timer; the source only
+  // provides user input
+  POMODORO_REPLAY_TIMEOUTS_SIMULATED,
+} pomodoro_replay_timeouts_t;
+
+typedef struct pomodoro_replay pomodoro_replay_t;
+
+/*
+ * @brief Produces the next scripted event.
+ *
+ * Called whenever the engine needs a new input. `replay` exposes the session
+ * and the virtual clock so that generators can react to the current state.
+ * The returned timestamp must not be earlier than `replay->now_ms`.
+ *
+ * @return false when the source is exhausted.
+ */
+typedef bool (*pomodoro_replay_source_fn)(void *ctx,
+                                          const pomodoro_replay_t *replay,
+                                          pomodoro_record_t *out);
+
+/*
+ * @brief Called for every event whose dispatch result differs from the one
+ * stored in the source record.
+ */
+typedef void (*pomodoro_replay_mismatch_fn)(void *ctx,
+                                            const pomodoro_replay_t *replay,
+                                            const pomodoro_record_t *expected,
+                                            pomodoro_err_t actual);
+
+typedef struct pomodoro_replay_stats {
+  uint64_t events;
+  uint64_t ui_events;
+  uint64_t dispatch_ok;
+  uint64_t dispatch_failed;
+  uint64_t timeouts_simulated;
+  uint64_t mismatches;
+  uint64_t phases_completed;
+  uint64_t sessions_finished;
+  // Largest distance between a recorded TIMEOUT and the simulated deadline
+  uint32_t max_timeout_drift_ms;
+} pomodoro_replay_stats_t;
+
+struct pomodoro_replay {
+  pomodoro_session_t session;
+  pomodoro_effects_t effects;
+  pomodoro_sim_timer_t timer;
+  pomodoro_replay_timeouts_t timeouts;
+
+  // Virtual clock. `now_ms` is what the FSM sees and wraps like the tick
+  // count does on the device; `elapsed_ms` is monotonic.
+  uint32_t now_ms;
+  uint64_t elapsed_ms;
+
+  pomodoro_replay_source_fn source;
+  void *source_ctx;
+  pomodoro_replay_mismatch_fn on_mismatch;
+  void *mismatch_ctx;
+
+  // One event of look-ahead so that simulated timeouts can be interleaved
+  pomodoro_record_t pending;
+  bool has_pending;
+  bool source_exhausted;
+
+  pomodoro_replay_stats_t stats;
+};
+
+void pomodoro_replay_initialize(pomodoro_replay_t *replay,
+                                const pomodoro_session_t *initial_session,
+                                uint32_t start_ms,
+                                pomodoro_replay_timeouts_t timeouts,
+                                pomodoro_replay_source_fn source,
+                                void *source_ctx);
+
+/*
+ * @brief Advances the virtual clock to the next event and dispatches it.
+ *
+ * @return false when there is nothing left to do: the source is exhausted and
+ * no simulated timer is pending.
+ */
+bool pomodoro_replay_step(pomodoro_replay_t *replay);
+
+/*
+ * @brief Steps until the source is exhausted or `max_elapsed_ms` of virtual
+ * time have passed.
+ */
+void pomodoro_replay_run(pomodoro_replay_t *replay, uint64_t max_elapsed_ms);
+
+// === Recordings ===
+
+typedef struct pomodoro_recording {
+  pomodoro_config_t config;
+  pomodoro_session_t base;
+  pomodoro_record_t records[POMODORO_RECORDER_CAPACITY];
+  uint32_t count;
+  uint32_t evicted;
+} pomodoro_recording_t;
+
+/*
+ * @brief Parses the output of `pomodoro_recorder_dump()`. Lines that are not
+ * part of the recording (logs, status lines) are skipped, so a raw serial
+ * capture can be fed directly. The first recording that ends with REC-END is
+ * loaded; one cut off before REC-END is skipped.
+ *
+ * @return POMODORO_STATUS_INVALID_ARGUMENTS if no complete recording was found,
+ * or if the first one does not match the phase and record counts announced by
+ * its REC-BEGIN.
+ */
+pomodoro_err_t pomodoro_recording_load(pomodoro_recording_t *recording,
+                                       FILE *in);
+
+/*
+ * @brief `pomodoro_replay_source_fn` that yields the records of a
+ * `pomodoro_replay_cursor_t`, in order.
+ */
+typedef struct pomodoro_replay_cursor {
+  const pomodoro_recording_t *recording;
+  uint32_t next;
+} pomodoro_replay_cursor_t;
+
+bool pomodoro_replay_recording_source(void *ctx,
+                                      const pomodoro_replay_t *replay,
+                                      pomodoro_record_t *out);
+
+#endif // POMODORO_REPLAY_H
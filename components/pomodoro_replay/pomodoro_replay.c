@@ -0,0 +1,355 @@
+#include "pomodoro_replay.h"
+#include <assert.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * @brief Record result meaning "no expectation", used by synthetic sources
+ */
+#define RESULT_UNKNOWN POMODORO_STATUS_COUNT
+
+void pomodoro_sim_timer_handle_effects(pomodoro_sim_timer_t *timer,
+                                       const pomodoro_effects_t *effects,
+                                       uint32_t now_ms) {
+  for (uint32_t i = 0; i < effects->count; i++) {
+    const pomodoro_effect_t *effect = &effects->effects[i];
+
+    switch (effect->type) {
+    case POMODORO_EFFECT_TIMER_START:
+      timer->armed[effect->timer_start.timer_id] = true;
+      timer->deadline_ms[effect->timer_start.timer_id] =
+          now_ms + effect->timer_start.timeout_ms;
+      break;
+    case POMODORO_EFFECT_TIMER_STOP:
+      if (effect->timer_stop.timer_id == POMODORO_TIMER_ALL) {
+        memset(timer->armed, 0, sizeof(timer->armed));
+      } else {
+        timer->armed[effect->timer_stop.timer_id] = false;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+bool pomodoro_sim_timer_next(const pomodoro_sim_timer_t *timer,
+                             pomodoro_timer_id_t *timer_id) {
+  bool found = false;
+  for (uint32_t id = 0; id < POMODORO_TIMER_COUNT; id++) {
+    if (!timer->armed[id]) {
+      continue;
+    }
+    // Ties go to the lower id, so the phase end wins over its reminders
+    if (!found || (int32_t)(timer->deadline_ms[id] -
+                            timer->deadline_ms[*timer_id]) < 0) {
+      *timer_id = (pomodoro_timer_id_t)id;
+      found = true;
+    }
+  }
+  return found;
+}
+
+void pomodoro_replay_initialize(pomodoro_replay_t *replay,
+                                const pomodoro_session_t *initial_session,
+                                uint32_t start_ms,
+                                pomodoro_replay_timeouts_t timeouts,
+                                pomodoro_replay_source_fn source,
+                                void *source_ctx) {
+  // Sanity checks
+  assert(replay != NULL);
+  assert(initial_session != NULL);
+  assert(source != NULL);
+
+  memset(replay, 0, sizeof(*replay));
+  memcpy(&replay->session, initial_session, sizeof(pomodoro_session_t));
+  pomodoro_effects_clear(&replay->effects);
+
+  replay->timeouts = timeouts;
+  replay->now_ms = start_ms;
+  replay->source = source;
+  replay->source_ctx = source_ctx;
+
+  // A session captured while running still has its deadline pending. Its
+  // reminders are not part of the session and are not restored.
+  if (initial_session->state == POMODORO_STATE_RUNNING) {
+    replay->timer.armed[POMODORO_TIMER_PHASE_END] = true;
+    replay->timer.deadline_ms[POMODORO_TIMER_PHASE_END] =
+        initial_session->end_time_ms;
+  }
+}
+
+static void advance_clock(pomodoro_replay_t *replay, uint32_t target_ms) {
+  int32_t delta = (int32_t)(target_ms - replay->now_ms);
+
+  // Never travel back in time, even if the source is out of order
+  if (delta > 0) {
+    replay->now_ms = target_ms;
+    replay->elapsed_ms += (uint32_t)delta;
+  }
+}
+
+static void dispatch(pomodoro_replay_t *replay,
+                     const pomodoro_record_t *record) {
+  pomodoro_replay_stats_t *stats = &replay->stats;
+  stats->events++;
+
+  if (record->event.type != REACTOR_FSM_EVENT) {
+    stats->ui_events++;
+    return;
+  }
+
+  uint32_t previous_phase = replay->session.phase_index;
+  pomodoro_state_t previous_state = replay->session.state;
+
+  pomodoro_err_t result =
+      pomodoro_session_dispatch(&replay->session, record->event.data.fsm_event,
+                                replay->now_ms, &replay->effects);
+
+  if (result == POMODORO_STATUS_OK) {
+    stats->dispatch_ok++;
+    pomodoro_sim_timer_handle_effects(&replay->timer, &replay->effects,
+                                      replay->now_ms);
+  } else {
+    stats->dispatch_failed++;
+  }
+
+  if (replay->session.phase_index > previous_phase) {
+    stats->phases_completed++;
+  }
+  if (replay->session.state == POMODORO_STATE_FINISHED &&
+      previous_state != POMODORO_STATE_FINISHED) {
+    stats->phases_completed++;
+    stats->sessions_finished++;
+  }
+
+  if (record->result != RESULT_UNKNOWN && record->result != result) {
+    stats->mismatches++;
+    if (replay->on_mismatch) {
+      replay->on_mismatch(replay->mismatch_ctx, replay, record, result);
+    }
+  }
+}
+
+static void track_timeout_drift(pomodoro_replay_t *replay,
+                                const pomodoro_record_t *record) {
+  if (record->event.type != REACTOR_FSM_EVENT ||
+      record->event.data.fsm_event != POMODORO_EVT_TIMEOUT ||
+      !replay->timer.armed[POMODORO_TIMER_PHASE_END]) {
+    return;
+  }
+
+  int32_t drift =
+      (int32_t)(record->event.timestamp_ms -
+                replay->timer.deadline_ms[POMODORO_TIMER_PHASE_END]);
+  uint32_t drift_ms = (drift < 0) ? (uint32_t)-drift : (uint32_t)drift;
+  if (drift_ms > replay->stats.max_timeout_drift_ms) {
+    replay->stats.max_timeout_drift_ms = drift_ms;
+  }
+}
+
+bool pomodoro_replay_step(pomodoro_replay_t *replay) {
+  if (!replay->has_pending && !replay->source_exhausted) {
+    replay->has_pending =
+        replay->source(replay->source_ctx, replay, &replay->pending);
+    replay->source_exhausted = !replay->has_pending;
+  }
+
+  pomodoro_timer_id_t timer_id = POMODORO_TIMER_PHASE_END;
+  bool timer_due =
+      replay->timeouts == POMODORO_REPLAY_TIMEOUTS_SIMULATED &&
+      pomodoro_sim_timer_next(&replay->timer, &timer_id);
+  if (timer_due && replay->has_pending) {
+    // Ties go to the timer, like a timeout that was queued first
+    timer_due = (int32_t)(replay->timer.deadline_ms[timer_id] -
+                          replay->pending.event.timestamp_ms) <= 0;
+  }
+
+  if (timer_due) {
+    pomodoro_record_t timeout = {
+        .event =
+            {
+                .type = REACTOR_FSM_EVENT,
+                .timestamp_ms = replay->timer.deadline_ms[timer_id],
+                .data.fsm_event = pomodoro_timer_event(timer_id),
+            },
+        .result = RESULT_UNKNOWN,
+    };
+    replay->timer.armed[timer_id] = false;
+    advance_clock(replay, timeout.event.timestamp_ms);
+    replay->stats.timeouts_simulated++;
+    dispatch(replay, &timeout);
+    return true;
+  }
+
+  if (!replay->has_pending) {
+    return false;
+  }
+
+  replay->has_pending = false;
+  advance_clock(replay, replay->pending.event.timestamp_ms);
+  if (replay->timeouts == POMODORO_REPLAY_TIMEOUTS_RECORDED) {
+    track_timeout_drift(replay, &replay->pending);
+  }
+  dispatch(replay, &replay->pending);
+  return true;
+}
+
+void pomodoro_replay_run(pomodoro_replay_t *replay, uint64_t max_elapsed_ms) {
+  while (replay->elapsed_ms < max_elapsed_ms && pomodoro_replay_step(replay)) {
+  }
+}
+
+// === Recordings ===
+
+static bool record_from_fields(pomodoro_record_t *record, int type,
+                               uint32_t timestamp_ms, uint32_t payload,
+                               int result) {
+  if (result < 0 || result >= POMODORO_STATUS_COUNT) {
+    return false;
+  }
+
+  switch (type) {
+  case REACTOR_FSM_EVENT:
+    if (payload >= POMODORO_EVT_COUNT) {
+      return false;
+    }
+    record->event.data.fsm_event = (pomodoro_event_t)payload;
+    break;
+  case REACTOR_UI_EVENT:
+    if (payload >= UI_EVT_COUNT) {
+      return false;
+    }
+    record->event.data.ui_event = (ui_event_type_t)payload;
+    break;
+  default:
+    return false;
+  }
+
+  record->event.type = (uint8_t)type;
+  // Stale timer events never reach the recorder
+  record->event.timer_generation = 0;
+  record->event.timestamp_ms = timestamp_ms;
+  record->result = (pomodoro_err_t)result;
+  return true;
+}
+
+// Whether the recording between REC-BEGIN and REC-END is whole: every phase
+// index and every record announced by REC-BEGIN was seen, and the base too
+static bool recording_complete(const pomodoro_recording_t *recording,
+                               uint32_t phases_expected,
+                               uint32_t phases_seen_mask,
+                               uint32_t records_expected, bool has_base) {
+  return has_base && phases_expected > 0 &&
+         recording->config.count == phases_expected &&
+         phases_seen_mask == (1u << phases_expected) - 1 &&
+         recording->count == records_expected &&
+         recording->base.phase_index < recording->config.count;
+}
+
+pomodoro_err_t pomodoro_recording_load(pomodoro_recording_t *recording,
+                                       FILE *in) {
+  if (recording == NULL || in == NULL) {
+    return POMODORO_STATUS_INVALID_ARGUMENTS;
+  }
+
+  _Static_assert(MAX_PHASES <= 32, "Phases seen are tracked in a uint32_t");
+
+  memset(recording, 0, sizeof(*recording));
+
+  char line[128];
+  bool in_recording = false;
+  bool has_base = false;
+  uint32_t phases_expected = 0;
+  uint32_t phases_seen_mask = 0;
+  uint32_t records_expected = 0;
+
+  while (fgets(line, sizeof(line), in) != NULL) {
+    // Tolerate log prefixes and other noise in front of the marker
+    const char *marker = strstr(line, "REC");
+    if (marker == NULL) {
+      continue;
+    }
+
+    uint32_t a, b, c;
+    int e;
+    int focus = 0; // Dumps from before `focus` was recorded have no field
+    char name[MAX_NAME];
+
+    if (sscanf(marker, "REC-BEGIN v1 phases=%" SCNu32 " records=%" SCNu32
+                       " evicted=%" SCNu32,
+               &a, &b, &c) == 3) {
+      if (a > MAX_PHASES || b > POMODORO_RECORDER_CAPACITY) {
+        return POMODORO_STATUS_INVALID_ARGUMENTS;
+      }
+      // Starts over: the recording before it was cut off without REC-END
+      memset(recording, 0, sizeof(*recording));
+      recording->evicted = c;
+      in_recording = true;
+      has_base = false;
+      phases_expected = a;
+      phases_seen_mask = 0;
+      records_expected = b;
+    } else if (!in_recording) {
+      continue;
+    } else if (sscanf(marker, "REC-PHASE %" SCNu32 " %24s %" SCNu32 " %d", &a,
+                      name, &b, &focus) >= 3) {
+      if (a >= phases_expected || (phases_seen_mask & (1u << a)) != 0 ||
+          (focus != 0 && focus != 1)) {
+        return POMODORO_STATUS_INVALID_ARGUMENTS;
+      }
+      snprintf(recording->config.phases[a].name, MAX_NAME, "%s", name);
+      recording->config.phases[a].duration_ms = b;
+      recording->config.phases[a].focus = focus == 1;
+      phases_seen_mask |= 1u << a;
+      if (a + 1 > recording->config.count) {
+        recording->config.count = a + 1;
+      }
+    } else if (sscanf(marker,
+                      "REC-BASE %d %" SCNu32 " %" SCNu32 " %" SCNu32, &e, &a,
+                      &b, &c) == 4) {
+      if (e < 0 || e >= POMODORO_STATE_COUNT) {
+        return POMODORO_STATUS_INVALID_ARGUMENTS;
+      }
+      recording->base.state = (pomodoro_state_t)e;
+      recording->base.phase_index = a;
+      recording->base.end_time_ms = b;
+      recording->base.remaining_ms = c;
+      has_base = true;
+    } else if (sscanf(marker, "REC %" SCNu32 " %" SCNu32 " %" SCNu32 " %d", &a,
+                      &b, &c, &e) == 4) {
+      if (recording->count >= records_expected ||
+          !record_from_fields(&recording->records[recording->count], (int)a, b,
+                              c, e)) {
+        return POMODORO_STATUS_INVALID_ARGUMENTS;
+      }
+      recording->count++;
+    } else if (strncmp(marker, "REC-END", 7) == 0) {
+      // The first complete recording of the capture is the one loaded
+      if (!recording_complete(recording, phases_expected, phases_seen_mask,
+                              records_expected, has_base)) {
+        return POMODORO_STATUS_INVALID_ARGUMENTS;
+      }
+      recording->base.config = &recording->config;
+      return POMODORO_STATUS_OK;
+    }
+  }
+
+  // Ran out of input before REC-END
+  return POMODORO_STATUS_INVALID_ARGUMENTS;
+}
+
+bool pomodoro_replay_recording_source(void *ctx,
+                                      const pomodoro_replay_t *replay,
+                                      pomodoro_record_t *out) {
+  (void)replay;
+  pomodoro_replay_cursor_t *cursor = (pomodoro_replay_cursor_t *)ctx;
+
+  if (cursor->next >= cursor->recording->count) {
+    return false;
+  }
+
+  *out = cursor->recording->records[cursor->next++];
+  return true;
+}
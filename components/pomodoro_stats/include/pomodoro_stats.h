@@ -0,0 +1,106 @@
+#ifndef POMODORO_STATS_H
+#define POMODORO_STATS_H
+
+#include "pomodoro_fsm.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// Rolling windows: the last 24 hours in hourly buckets, the last 7 days in
+// daily buckets
+#define STATS_HOUR_MS (60u * 60u * 1000u)
+#define STATS_DAY_MS (24u * STATS_HOUR_MS)
+#define STATS_HOUR_BUCKETS 24
+#define STATS_DAY_BUCKETS 7
+
+// `now_ms` taken by other tasks may reach the statistics slightly out of
+// order. A timestamp at most this much older than the last one is ignored,
+// anything else counts as time going forward.
+#define STATS_MAX_REORDER_MS (60u * 1000u)
+
+/*
+ * @brief Ring of fixed-width time buckets holding a running total.
+ *
+ * Buckets are indexed by `epoch = elapsed_ms / bucket_ms`. Moving to a newer
+ * epoch clears the buckets that fell out of the window and subtracts them from
+ * the total, so the total always covers the last `length` buckets.
+ */
+typedef struct pomodoro_stats_ring {
+  uint32_t *buckets;
+  uint32_t length;
+  uint32_t bucket_ms;
+  uint64_t newest_epoch;
+  uint64_t total;
+} pomodoro_stats_ring_t;
+
+typedef struct pomodoro_stats_phase {
+  const char *name; // Points into the session config
+  uint32_t completed;
+  uint32_t skipped;
+  uint64_t running_ms;
+} pomodoro_stats_phase_t;
+
+/*
+ * @brief Session statistics, fed by FSM transitions.
+ *
+ * Everything is sized at compile time and updated in constant time: the only
+ * loops are bounded by the bucket counts above. Time is taken from the same
+ * `now_ms` as the FSM, so "today" means the last 24 hours since boot, not a
+ * calendar day.
+ */
+typedef struct pomodoro_stats {
+  // Phases are aggregated by name: "Work" counts all of its occurrences
+  pomodoro_stats_phase_t by_name[MAX_PHASES];
+  uint8_t name_of_phase[MAX_PHASES];
+  uint32_t name_count;
+
+  uint64_t focused_ms;
+  uint64_t paused_ms;
+  uint32_t focus_completed;
+
+  // Monotonic clock built from the wrapping `now_ms`
+  uint32_t last_ms;
+  uint64_t elapsed_ms;
+
+  pomodoro_stats_ring_t focused_hourly;
+  pomodoro_stats_ring_t focused_daily;
+  pomodoro_stats_ring_t completed_hourly;
+  pomodoro_stats_ring_t completed_daily;
+
+  uint32_t focused_hourly_buckets[STATS_HOUR_BUCKETS];
+  uint32_t focused_daily_buckets[STATS_DAY_BUCKETS];
+  uint32_t completed_hourly_buckets[STATS_HOUR_BUCKETS];
+  uint32_t completed_daily_buckets[STATS_DAY_BUCKETS];
+} pomodoro_stats_t;
+
+void pomodoro_stats_initialize(pomodoro_stats_t *stats,
+                               const pomodoro_config_t *config,
+                               uint32_t now_ms);
+
+/*
+ * @brief Accounts the time spent in `session`'s current state up to `now_ms`.
+ * Call before reading the aggregates of a session that is still running.
+ *
+ * `now_ms` wraps every ~49.7 days, so call this more often than that (the
+ * reactor does every STATS_HOUR_MS), or the time in between is lost.
+ */
+void pomodoro_stats_advance(pomodoro_stats_t *stats,
+                            const pomodoro_session_t *session, uint32_t now_ms);
+
+/*
+ * @brief Feeds a successful transition from `before` to `after`.
+ */
+void pomodoro_stats_on_transition(pomodoro_stats_t *stats,
+                                  const pomodoro_session_t *before,
+                                  pomodoro_event_t event,
+                                  const pomodoro_session_t *after,
+                                  uint32_t now_ms);
+
+/*
+ * @brief Copies `src` into `dst`. A plain struct copy would leave the rings of
+ * `dst` pointing at the buckets of `src`.
+ */
+void pomodoro_stats_copy(pomodoro_stats_t *dst, const pomodoro_stats_t *src);
+
+void pomodoro_stats_dump(const pomodoro_stats_t *stats, FILE *out);
+
+#endif // POMODORO_STATS_H
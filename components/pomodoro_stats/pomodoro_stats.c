@@ -0,0 +1,222 @@
+#include "pomodoro_stats.h"
+#include <assert.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#define MS_PER_MINUTE 60000u
+
+// === Rings ===
+
+static void ring_initialize(pomodoro_stats_ring_t *ring, uint32_t *buckets,
+                            uint32_t length, uint32_t bucket_ms) {
+  ring->buckets = buckets;
+  ring->length = length;
+  ring->bucket_ms = bucket_ms;
+  ring->newest_epoch = 0;
+  ring->total = 0;
+  memset(buckets, 0, length * sizeof(uint32_t));
+}
+
+static void ring_roll(pomodoro_stats_ring_t *ring, uint64_t epoch) {
+  if (epoch <= ring->newest_epoch) {
+    return;
+  }
+
+  if (epoch - ring->newest_epoch >= ring->length) {
+    // The whole window expired
+    memset(ring->buckets, 0, ring->length * sizeof(uint32_t));
+    ring->total = 0;
+  } else {
+    for (uint64_t e = ring->newest_epoch + 1; e <= epoch; e++) {
+      uint32_t *bucket = &ring->buckets[e % ring->length];
+      ring->total -= *bucket;
+      *bucket = 0;
+    }
+  }
+
+  ring->newest_epoch = epoch;
+}
+
+static void ring_add_at(pomodoro_stats_ring_t *ring, uint64_t elapsed_ms,
+                        uint32_t value) {
+  uint64_t epoch = elapsed_ms / ring->bucket_ms;
+  ring_roll(ring, epoch);
+  ring->buckets[epoch % ring->length] += value;
+  ring->total += value;
+}
+
+/*
+ * @brief Spreads the interval [start_ms, end_ms) over the buckets it covers.
+ * Only the part that is still inside the window is visited, so this runs at
+ * most `length + 1` iterations however long the interval is.
+ */
+static void ring_add_interval(pomodoro_stats_ring_t *ring, uint64_t start_ms,
+                              uint64_t end_ms) {
+  uint64_t window_ms = (uint64_t)ring->length * ring->bucket_ms;
+  if (end_ms - start_ms > window_ms) {
+    start_ms = end_ms - window_ms;
+  }
+
+  while (start_ms < end_ms) {
+    uint64_t boundary = (start_ms / ring->bucket_ms + 1) * ring->bucket_ms;
+    uint64_t chunk_end = boundary < end_ms ? boundary : end_ms;
+    ring_add_at(ring, start_ms, (uint32_t)(chunk_end - start_ms));
+    start_ms = chunk_end;
+  }
+}
+
+static uint64_t ring_total(const pomodoro_stats_ring_t *ring,
+                           uint64_t elapsed_ms) {
+  // Buckets that expired since the last write are not part of the window
+  uint64_t epoch = elapsed_ms / ring->bucket_ms;
+  if (epoch - ring->newest_epoch >= ring->length) {
+    return 0;
+  }
+
+  uint64_t total = ring->total;
+  for (uint64_t e = ring->newest_epoch + 1; e <= epoch; e++) {
+    total -= ring->buckets[e % ring->length];
+  }
+  return total;
+}
+
+// === Stats ===
+
+void pomodoro_stats_initialize(pomodoro_stats_t *stats,
+                               const pomodoro_config_t *config,
+                               uint32_t now_ms) {
+  // Sanity checks
+  assert(stats != NULL);
+  assert(config != NULL);
+  assert(config->count <= MAX_PHASES);
+
+  memset(stats, 0, sizeof(*stats));
+  stats->last_ms = now_ms;
+
+  // Resolve names once so that transitions only do an index lookup
+  for (uint32_t i = 0; i < config->count; i++) {
+    uint32_t slot = 0;
+    while (slot < stats->name_count &&
+           strcmp(stats->by_name[slot].name, config->phases[i].name) != 0) {
+      slot++;
+    }
+    if (slot == stats->name_count) {
+      stats->by_name[slot].name = config->phases[i].name;
+      stats->name_count++;
+    }
+    stats->name_of_phase[i] = (uint8_t)slot;
+  }
+
+  ring_initialize(&stats->focused_hourly, stats->focused_hourly_buckets,
+                  STATS_HOUR_BUCKETS, STATS_HOUR_MS);
+  ring_initialize(&stats->focused_daily, stats->focused_daily_buckets,
+                  STATS_DAY_BUCKETS, STATS_DAY_MS);
+  ring_initialize(&stats->completed_hourly, stats->completed_hourly_buckets,
+                  STATS_HOUR_BUCKETS, STATS_HOUR_MS);
+  ring_initialize(&stats->completed_daily, stats->completed_daily_buckets,
+                  STATS_DAY_BUCKETS, STATS_DAY_MS);
+}
+
+void pomodoro_stats_advance(pomodoro_stats_t *stats,
+                            const pomodoro_session_t *session,
+                            uint32_t now_ms) {
+  // Unsigned: a signed delta would turn negative after ~24.8 days
+  uint32_t delta = now_ms - stats->last_ms;
+  if (delta == 0 || delta > UINT32_MAX - STATS_MAX_REORDER_MS) {
+    return;
+  }
+
+  uint64_t start_ms = stats->elapsed_ms;
+  stats->elapsed_ms += delta;
+  stats->last_ms = now_ms;
+
+  switch (session->state) {
+  case POMODORO_STATE_RUNNING: {
+    const pomodoro_phase_t *phase = pomodoro_current_phase(session);
+    stats->by_name[stats->name_of_phase[session->phase_index]].running_ms +=
+        delta;
+
+    if (phase->focus) {
+      stats->focused_ms += delta;
+      ring_add_interval(&stats->focused_hourly, start_ms, stats->elapsed_ms);
+      ring_add_interval(&stats->focused_daily, start_ms, stats->elapsed_ms);
+    }
+  } break;
+
+  case POMODORO_STATE_PAUSED:
+    stats->paused_ms += delta;
+    break;
+
+  default:
+    break;
+  }
+}
+
+void pomodoro_stats_on_transition(pomodoro_stats_t *stats,
+                                  const pomodoro_session_t *before,
+                                  pomodoro_event_t event,
+                                  const pomodoro_session_t *after,
+                                  uint32_t now_ms) {
+  pomodoro_stats_advance(stats, before, now_ms);
+
+  bool left_phase = after->phase_index != before->phase_index ||
+                    (after->state == POMODORO_STATE_FINISHED &&
+                     before->state != POMODORO_STATE_FINISHED);
+
+  // A restart also leaves the phase, but does not count as finishing it
+  if (!left_phase || event == POMODORO_EVT_RESTART) {
+    return;
+  }
+
+  pomodoro_stats_phase_t *phase =
+      &stats->by_name[stats->name_of_phase[before->phase_index]];
+
+  if (event == POMODORO_EVT_SKIP) {
+    phase->skipped++;
+    return;
+  }
+
+  phase->completed++;
+  if (pomodoro_current_phase(before)->focus) {
+    stats->focus_completed++;
+    ring_add_at(&stats->completed_hourly, stats->elapsed_ms, 1);
+    ring_add_at(&stats->completed_daily, stats->elapsed_ms, 1);
+  }
+}
+
+void pomodoro_stats_copy(pomodoro_stats_t *dst, const pomodoro_stats_t *src) {
+  memcpy(dst, src, sizeof(*dst));
+
+  dst->focused_hourly.buckets = dst->focused_hourly_buckets;
+  dst->focused_daily.buckets = dst->focused_daily_buckets;
+  dst->completed_hourly.buckets = dst->completed_hourly_buckets;
+  dst->completed_daily.buckets = dst->completed_daily_buckets;
+}
+
+void pomodoro_stats_dump(const pomodoro_stats_t *stats, FILE *out) {
+  uint64_t now = stats->elapsed_ms;
+
+  fprintf(out,
+          "stats focused_min_total=%" PRIu64 " paused_min_total=%" PRIu64
+          " focus_completed=%" PRIu32 " footprint_bytes=%zu\n",
+          stats->focused_ms / MS_PER_MINUTE, stats->paused_ms / MS_PER_MINUTE,
+          stats->focus_completed, sizeof(pomodoro_stats_t));
+
+  fprintf(out,
+          "stats focused_min_24h=%" PRIu64 " focused_min_7d=%" PRIu64
+          " completed_24h=%" PRIu64 " completed_7d=%" PRIu64 "\n",
+          ring_total(&stats->focused_hourly, now) / MS_PER_MINUTE,
+          ring_total(&stats->focused_daily, now) / MS_PER_MINUTE,
+          ring_total(&stats->completed_hourly, now),
+          ring_total(&stats->completed_daily, now));
+
+  for (uint32_t i = 0; i < stats->name_count; i++) {
+    const pomodoro_stats_phase_t *phase = &stats->by_name[i];
+    fprintf(out,
+            "stats phase=\"%s\" completed=%" PRIu32 " skipped=%" PRIu32
+            " running_s=%" PRIu64 "\n",
+            phase->name, phase->completed, phase->skipped,
+            phase->running_ms / 1000);
+  }
+}
@@ -0,0 +1,89 @@
+#ifndef POMODORO_TELEMETRY_H
+#define POMODORO_TELEMETRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary telemetry frames
+ *
+ *   0xA5 | length | payload (length bytes) | crc8
+ *
+ * The CRC-8 (polynomial 0x07, init 0x00) covers `length` and the payload.
+ *
+ * Payload:
+ *
+ *   flags (1 byte)  bit 7: keyframe, bits 0-4: field present
+ *   seq   (1 byte)  frame counter, wraps at 256
+ *   [keyframe only] interval_ms (varint)
+ *   fields, in bit order, only when their bit is set:
+ *     0 timestamp_ms   key: varint   delta: zigzag(dt - interval_ms)
+ *     1 state          1 byte
+ *     2 phase_index    varint
+ *     3 remaining_ms   key: varint   delta: zigzag(actual - predicted)
+ *     4 transitions    key: varint   delta: varint(increase)
+ *
+ * Delta frames omit every field that matches the decoder's prediction: the
+ * timestamp advanced by exactly `interval_ms`, state/phase/transitions did not
+ * change, and, while running in both frames, `remaining_ms` went down by the
+ * elapsed time (otherwise it did not change). A steady running session
+ * therefore costs 5 bytes per record. Keyframes carry every field in absolute
+ * form and let a decoder (re)synchronize.
+ */
+
+#define POMODORO_TELEMETRY_SYNC 0xA5
+#define POMODORO_TELEMETRY_MAX_FRAME 40
+
+#define POMODORO_TELEMETRY_FLAG_KEYFRAME 0x80
+
+typedef enum pomodoro_telemetry_field {
+  POMODORO_TELEMETRY_FIELD_TIMESTAMP = 0,
+  POMODORO_TELEMETRY_FIELD_STATE,
+  POMODORO_TELEMETRY_FIELD_PHASE_INDEX,
+  POMODORO_TELEMETRY_FIELD_REMAINING,
+  POMODORO_TELEMETRY_FIELD_TRANSITIONS,
+  // MUST BE LAST: Used for getting the count
+  POMODORO_TELEMETRY_FIELD_COUNT,
+} pomodoro_telemetry_field_t;
+
+typedef struct pomodoro_telemetry_sample {
+  uint32_t timestamp_ms;
+  uint8_t state; // pomodoro_state_t
+  uint32_t phase_index;
+  uint32_t remaining_ms;
+  uint32_t transitions;
+} pomodoro_telemetry_sample_t;
+
+typedef struct pomodoro_telemetry_encoder {
+  pomodoro_telemetry_sample_t previous;
+  bool has_previous;
+  uint32_t interval_ms;
+  uint32_t keyframe_every; // Records between keyframes
+  uint32_t since_keyframe;
+  uint8_t seq;
+} pomodoro_telemetry_encoder_t;
+
+void pomodoro_telemetry_encoder_initialize(
+    pomodoro_telemetry_encoder_t *encoder, uint32_t interval_ms,
+    uint32_t keyframe_every);
+
+/*
+ * @brief Switches to `interval_ms` and makes the next record a keyframe, which
+ * carries the new interval. `seq` is kept, so a decoder does not mistake the
+ * switch for lost frames.
+ */
+void pomodoro_telemetry_encoder_reset(pomodoro_telemetry_encoder_t *encoder,
+                                      uint32_t interval_ms);
+
+/*
+ * @brief Encodes `sample` into a complete frame.
+ *
+ * @return frame length in bytes, or 0 if `capacity` is smaller than
+ * POMODORO_TELEMETRY_MAX_FRAME.
+ */
+size_t pomodoro_telemetry_encode(pomodoro_telemetry_encoder_t *encoder,
+                                 const pomodoro_telemetry_sample_t *sample,
+                                 uint8_t *out, size_t capacity);
+
+#endif // POMODORO_TELEMETRY_H
@@ -0,0 +1,163 @@
+#include "pomodoro_telemetry.h"
+#include "pomodoro_fsm.h"
+#include <assert.h>
+#include <string.h>
+
+#define FIELD_BIT(field) (1u << (field))
+
+typedef struct frame_writer {
+  uint8_t *buffer;
+  size_t length;
+} frame_writer_t;
+
+static void write_byte(frame_writer_t *writer, uint8_t value) {
+  writer->buffer[writer->length++] = value;
+}
+
+// LEB128: 7 bits per byte, high bit set on all but the last byte
+static void write_varint(frame_writer_t *writer, uint32_t value) {
+  while (value >= 0x80) {
+    write_byte(writer, (uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  write_byte(writer, (uint8_t)value);
+}
+
+// Maps small negative numbers to small varints: 0, -1, 1, -2... -> 0, 1, 2, 3
+static void write_zigzag(frame_writer_t *writer, int32_t value) {
+  write_varint(writer, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+static uint8_t crc8(const uint8_t *data, size_t length) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static bool is_running(const pomodoro_telemetry_sample_t *sample) {
+  return sample->state == POMODORO_STATE_RUNNING;
+}
+
+static uint32_t predict_remaining(const pomodoro_telemetry_sample_t *previous,
+                                  const pomodoro_telemetry_sample_t *sample) {
+  if (!is_running(previous) || !is_running(sample)) {
+    return previous->remaining_ms;
+  }
+
+  uint32_t elapsed_ms = sample->timestamp_ms - previous->timestamp_ms;
+  return previous->remaining_ms > elapsed_ms
+             ? previous->remaining_ms - elapsed_ms
+             : 0;
+}
+
+void pomodoro_telemetry_encoder_initialize(
+    pomodoro_telemetry_encoder_t *encoder, uint32_t interval_ms,
+    uint32_t keyframe_every) {
+  assert(encoder != NULL);
+
+  memset(encoder, 0, sizeof(*encoder));
+  encoder->interval_ms = interval_ms;
+  encoder->keyframe_every = keyframe_every > 0 ? keyframe_every : 1;
+}
+
+void pomodoro_telemetry_encoder_reset(pomodoro_telemetry_encoder_t *encoder,
+                                      uint32_t interval_ms) {
+  assert(encoder != NULL);
+
+  encoder->interval_ms = interval_ms;
+  encoder->has_previous = false;
+}
+
+static void write_keyframe_fields(frame_writer_t *writer,
+                                  const pomodoro_telemetry_encoder_t *encoder,
+                                  const pomodoro_telemetry_sample_t *sample) {
+  write_varint(writer, encoder->interval_ms);
+  write_varint(writer, sample->timestamp_ms);
+  write_byte(writer, sample->state);
+  write_varint(writer, sample->phase_index);
+  write_varint(writer, sample->remaining_ms);
+  write_varint(writer, sample->transitions);
+}
+
+static uint8_t write_delta_fields(frame_writer_t *writer,
+                                  const pomodoro_telemetry_encoder_t *encoder,
+                                  const pomodoro_telemetry_sample_t *sample) {
+  const pomodoro_telemetry_sample_t *previous = &encoder->previous;
+  uint8_t flags = 0;
+
+  int32_t timestamp_error = (int32_t)(sample->timestamp_ms -
+                                      previous->timestamp_ms -
+                                      encoder->interval_ms);
+  if (timestamp_error != 0) {
+    flags |= FIELD_BIT(POMODORO_TELEMETRY_FIELD_TIMESTAMP);
+    write_zigzag(writer, timestamp_error);
+  }
+
+  if (sample->state != previous->state) {
+    flags |= FIELD_BIT(POMODORO_TELEMETRY_FIELD_STATE);
+    write_byte(writer, sample->state);
+  }
+
+  if (sample->phase_index != previous->phase_index) {
+    flags |= FIELD_BIT(POMODORO_TELEMETRY_FIELD_PHASE_INDEX);
+    write_varint(writer, sample->phase_index);
+  }
+
+  int32_t remaining_error =
+      (int32_t)(sample->remaining_ms - predict_remaining(previous, sample));
+  if (remaining_error != 0) {
+    flags |= FIELD_BIT(POMODORO_TELEMETRY_FIELD_REMAINING);
+    write_zigzag(writer, remaining_error);
+  }
+
+  if (sample->transitions != previous->transitions) {
+    flags |= FIELD_BIT(POMODORO_TELEMETRY_FIELD_TRANSITIONS);
+    write_varint(writer, sample->transitions - previous->transitions);
+  }
+
+  return flags;
+}
+
+size_t pomodoro_telemetry_encode(pomodoro_telemetry_encoder_t *encoder,
+                                 const pomodoro_telemetry_sample_t *sample,
+                                 uint8_t *out, size_t capacity) {
+  assert(encoder != NULL);
+  assert(sample != NULL);
+
+  if (out == NULL || capacity < POMODORO_TELEMETRY_MAX_FRAME) {
+    return 0;
+  }
+
+  bool keyframe = !encoder->has_previous ||
+                  encoder->since_keyframe + 1 >= encoder->keyframe_every;
+
+  // Header is filled in once the payload length and flags are known
+  frame_writer_t writer = {.buffer = out, .length = 4};
+
+  uint8_t flags;
+  if (keyframe) {
+    flags = POMODORO_TELEMETRY_FLAG_KEYFRAME |
+            ((1u << POMODORO_TELEMETRY_FIELD_COUNT) - 1);
+    write_keyframe_fields(&writer, encoder, sample);
+    encoder->since_keyframe = 0;
+  } else {
+    flags = write_delta_fields(&writer, encoder, sample);
+    encoder->since_keyframe++;
+  }
+
+  out[0] = POMODORO_TELEMETRY_SYNC;
+  out[1] = (uint8_t)(writer.length - 2); // flags + seq + fields
+  out[2] = flags;
+  out[3] = encoder->seq++;
+  write_byte(&writer, crc8(&out[1], writer.length - 1));
+
+  encoder->previous = *sample;
+  encoder->has_previous = true;
+
+  return writer.length;
+}
@@ -4,17 +4,71 @@
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "pomodoro_effect_bus.h"
 #include "pomodoro_fsm.h"
+#include "pomodoro_reactor_types.h"
+#include <stdatomic.h>
+#include <stdbool.h>
 
+// Ticks the esp_timer callback waits for `lock` before trying again later
+#define POMODORO_TIMER_LOCK_WAIT_TICKS 1
+#define POMODORO_TIMER_RETRY_US 1000
+
+typedef struct pomodoro_timer_deadline {
+  int64_t deadline_us; // esp_timer_get_time() at which it expires
+  pomodoro_timer_id_t timer_id;
+  uint16_t generation; // generations[timer_id] when it was armed
+} pomodoro_timer_deadline_t;
+
+/*
+ * @brief Named deadlines multiplexed onto a single esp_timer.
+ *
+ * `deadlines` is kept sorted by expiry and holds at most one entry per timer
+ * id, so the hardware timer only ever needs to be armed for `deadlines[0]`.
+ * Effects are applied from the reactor task and expiries are handled from the
+ * esp_timer task, `lock` serializes both. Effects only hold it for a table
+ * update, so the callback waits at most POMODORO_TIMER_LOCK_WAIT_TICKS and
+ * otherwise runs again POMODORO_TIMER_RETRY_US later: due deadlines stay in
+ * the table until an expiry is sent for them.
+ *
+ * Arming or stopping a timer bumps its generation, and each expiry carries
+ * the generation of its deadline. An expiry that was already queued when its
+ * timer got re-armed or stopped is stale, pomodoro_timer_is_current() tells.
+ */
 typedef struct pomodoro_timer_context {
   esp_timer_create_args_t timer_args;
   esp_timer_handle_t timer_handle;
+  QueueHandle_t queue;
+  SemaphoreHandle_t lock;
+  pomodoro_timer_deadline_t deadlines[POMODORO_TIMER_COUNT];
+  uint32_t deadline_count;
+  // Only touched by the reactor task, the callback reads the deadline's copy
+  uint16_t generations[POMODORO_TIMER_COUNT];
+  // Expiries lost because the reactor queue was full, read by the reactor
+  _Atomic uint32_t dropped;
+  _Atomic uint32_t lock_retries; // Callbacks postponed because of `lock`
 } pomodoro_timer_context_t;
 
 void pomodoro_timer_context_initialize(pomodoro_timer_context_t *context,
                                        QueueHandle_t queue);
 
-void pomodoro_timer_handle_effects(pomodoro_timer_context_t *context,
-                                   const pomodoro_effects_t *effects);
+// Effect types `pomodoro_timer_handle_effect` acts upon
+#define POMODORO_TIMER_EFFECTS_MASK                                            \
+  (POMODORO_EFFECT_MASK(POMODORO_EFFECT_TIMER_START) |                         \
+   POMODORO_EFFECT_MASK(POMODORO_EFFECT_TIMER_STOP))
+
+/*
+ * @brief Effect bus handler, `ctx` is a `pomodoro_timer_context_t`
+ */
+void pomodoro_timer_handle_effect(void *ctx, const pomodoro_effect_t *effect);
+
+/*
+ * @brief Whether `event` may be dispatched: false for an expiry whose timer
+ * was re-armed or stopped after it was queued. Events that do not come from
+ * the timer are always current. Call from the reactor task.
+ */
+bool pomodoro_timer_is_current(const pomodoro_timer_context_t *context,
+                               const timestamped_event_t *event);
 
 #endif // POMODORO_TIMER_H
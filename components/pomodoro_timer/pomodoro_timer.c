@@ -1,45 +1,172 @@
 #include "pomodoro_timer.h"
 #include "freertos/FreeRTOS.h"
-#include "pomodoro_reactor_types.h"
+#include <assert.h>
+#include <string.h>
 
-static void timer_callback(void *args) {
-  QueueHandle_t queue = (QueueHandle_t)args;
+// === Generations, reactor task only ===
+
+// 0 is reserved for events that do not come from the timer
+static void next_generation(pomodoro_timer_context_t *context,
+                            pomodoro_timer_id_t timer_id) {
+  if (++context->generations[timer_id] == 0) {
+    context->generations[timer_id] = 1;
+  }
+}
+
+// === Deadline table, callers hold `context->lock` ===
+
+static void remove_deadline(pomodoro_timer_context_t *context,
+                            pomodoro_timer_id_t timer_id) {
+  for (uint32_t i = 0; i < context->deadline_count; i++) {
+    if (context->deadlines[i].timer_id == timer_id) {
+      memmove(&context->deadlines[i], &context->deadlines[i + 1],
+              (context->deadline_count - i - 1) *
+                  sizeof(pomodoro_timer_deadline_t));
+      context->deadline_count--;
+      return;
+    }
+  }
+}
+
+static void insert_deadline(pomodoro_timer_context_t *context,
+                            pomodoro_timer_id_t timer_id, int64_t deadline_us,
+                            uint16_t generation) {
+  // Re-arming a timer replaces its previous deadline
+  remove_deadline(context, timer_id);
+  assert(context->deadline_count < POMODORO_TIMER_COUNT);
 
-  timestamped_event_t evt = {
-      .type = REACTOR_FSM_EVENT,
-      .timestamp_ms = pdTICKS_TO_MS(xTaskGetTickCount()),
-      .data.fsm_event = POMODORO_EVT_TIMEOUT,
+  // Ties keep insertion order
+  uint32_t i = context->deadline_count;
+  while (i > 0 && context->deadlines[i - 1].deadline_us > deadline_us) {
+    context->deadlines[i] = context->deadlines[i - 1];
+    i--;
+  }
+  context->deadlines[i] = (pomodoro_timer_deadline_t){
+      .deadline_us = deadline_us,
+      .timer_id = timer_id,
+      .generation = generation,
   };
+  context->deadline_count++;
+}
+
+static void rearm(pomodoro_timer_context_t *context, int64_t now_us) {
+  esp_timer_stop(context->timer_handle);
+
+  if (context->deadline_count == 0) {
+    return;
+  }
 
-  xQueueSend(queue, &evt, 0);
+  int64_t timeout_us = context->deadlines[0].deadline_us - now_us;
+  esp_timer_start_once(context->timer_handle,
+                       timeout_us > 0 ? (uint64_t)timeout_us : 0);
+}
+
+// === Callbacks ===
+
+static void timer_callback(void *args) {
+  pomodoro_timer_context_t *context = (pomodoro_timer_context_t *)args;
+
+  if (xSemaphoreTake(context->lock, POMODORO_TIMER_LOCK_WAIT_TICKS) !=
+      pdTRUE) {
+    // Nothing was removed from the table. Fails harmlessly if the lock holder
+    // already re-armed the timer.
+    atomic_fetch_add(&context->lock_retries, 1);
+    esp_timer_start_once(context->timer_handle, POMODORO_TIMER_RETRY_US);
+    return;
+  }
+
+  int64_t now_us = esp_timer_get_time();
+  uint32_t expired = 0;
+  while (expired < context->deadline_count &&
+         context->deadlines[expired].deadline_us <= now_us) {
+    timestamped_event_t evt = {
+        .type = REACTOR_FSM_EVENT,
+        .timer_generation = context->deadlines[expired].generation,
+        .timestamp_ms = pdTICKS_TO_MS(xTaskGetTickCount()),
+        .data.fsm_event =
+            pomodoro_timer_event(context->deadlines[expired].timer_id),
+    };
+    if (xQueueSend(context->queue, &evt, 0) != pdTRUE) {
+      atomic_fetch_add(&context->dropped, 1);
+    }
+    expired++;
+  }
+
+  context->deadline_count -= expired;
+  memmove(&context->deadlines[0], &context->deadlines[expired],
+          context->deadline_count * sizeof(pomodoro_timer_deadline_t));
+
+  rearm(context, now_us);
+
+  xSemaphoreGive(context->lock);
 }
 
 void pomodoro_timer_context_initialize(pomodoro_timer_context_t *context,
                                        QueueHandle_t queue) {
+  context->queue = queue;
+  context->deadline_count = 0;
+  for (uint32_t i = 0; i < POMODORO_TIMER_COUNT; i++) {
+    context->generations[i] = 1;
+  }
+  atomic_init(&context->dropped, 0);
+  atomic_init(&context->lock_retries, 0);
+  context->lock = xSemaphoreCreateMutex();
+  configASSERT(context->lock != NULL);
+
   esp_timer_create_args_t *timer_args = &context->timer_args;
   timer_args->name = "focus_timer";
   timer_args->callback = timer_callback;
-  timer_args->arg = queue;
+  timer_args->arg = context;
 
   esp_timer_create(&context->timer_args, &context->timer_handle);
 }
 
-void pomodoro_timer_handle_effects(pomodoro_timer_context_t *context,
-                                   const pomodoro_effects_t *effects) {
-  for (uint32_t i = 0; i < effects->count; i++) {
-    pomodoro_effect_t effect = effects->effects[i];
-
-    uint32_t timeout_ms;
-    switch (effect.type) {
-    case POMODORO_EFFECT_TIMER_START:
-      timeout_ms = effect.timer_start.timeout_ms;
-      esp_timer_start_once(context->timer_handle, (uint64_t)timeout_ms * 1000);
-      break;
-    case POMODORO_EFFECT_TIMER_STOP:
-      esp_timer_stop(context->timer_handle);
-      break;
-    default:
-      break;
+void pomodoro_timer_handle_effect(void *ctx, const pomodoro_effect_t *effect) {
+  pomodoro_timer_context_t *context = (pomodoro_timer_context_t *)ctx;
+
+  xSemaphoreTake(context->lock, portMAX_DELAY);
+
+  int64_t now_us = esp_timer_get_time();
+  uint32_t timeout_ms;
+  switch (effect->type) {
+  case POMODORO_EFFECT_TIMER_START:
+    timeout_ms = effect->timer_start.timeout_ms;
+    next_generation(context, effect->timer_start.timer_id);
+    insert_deadline(context, effect->timer_start.timer_id,
+                    now_us + (int64_t)timeout_ms * 1000,
+                    context->generations[effect->timer_start.timer_id]);
+    break;
+  case POMODORO_EFFECT_TIMER_STOP:
+    if (effect->timer_stop.timer_id == POMODORO_TIMER_ALL) {
+      context->deadline_count = 0;
+      for (uint32_t i = 0; i < POMODORO_TIMER_COUNT; i++) {
+        next_generation(context, (pomodoro_timer_id_t)i);
+      }
+    } else {
+      remove_deadline(context, effect->timer_stop.timer_id);
+      next_generation(context, effect->timer_stop.timer_id);
+    }
+    break;
+  default:
+    break;
+  }
+
+  rearm(context, now_us);
+
+  xSemaphoreGive(context->lock);
+}
+
+bool pomodoro_timer_is_current(const pomodoro_timer_context_t *context,
+                               const timestamped_event_t *event) {
+  if (event->type != REACTOR_FSM_EVENT || event->timer_generation == 0) {
+    return true;
+  }
+
+  for (uint32_t i = 0; i < POMODORO_TIMER_COUNT; i++) {
+    if (pomodoro_timer_event((pomodoro_timer_id_t)i) ==
+        event->data.fsm_event) {
+      return context->generations[i] == event->timer_generation;
     }
   }
+  return true;
 }
@@ -2,10 +2,20 @@
 #define POMODORO_UART_H
 
 #include "freertos/FreeRTOS.h"
+#include <stddef.h>
 #include <stdint.h>
 
 void configure_uart(void);
+char *str_trim(char *s);
 esp_err_t read_line(char *buf, uint32_t length, TickType_t ticks_to_wait,
                     char **out_trimmed);
 
+/*
+ * @brief Writes binary data to the console as is, after flushing stdout.
+ *
+ * stdout turns every `\n` into `\r\n` on the chips, which corrupts any binary
+ * frame containing a 0x0A byte.
+ */
+esp_err_t write_raw(const void *data, size_t length);
+
 #endif // POMODORO_UART_H
@@ -1,9 +1,72 @@
 #include "pomodoro_uart.h"
-#include "driver/uart.h"
 #include "esp_err.h"
+#include "sdkconfig.h"
 #include <ctype.h>
 #include <string.h>
 
+#if CONFIG_IDF_TARGET_LINUX
+// No UART on the host: commands come from stdin
+#include "freertos/task.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+void configure_uart(void) {
+  // Non-blocking, so that waiting for input does not stall the other tasks
+  int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
+  fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
+  // Output is usually a pipe under test, flush every line
+  setvbuf(stdout, NULL, _IOLBF, 0);
+}
+
+/*
+ * @brief Same contract as `uart_read_bytes` for a single byte.
+ */
+static int read_byte(uint8_t *out, TickType_t ticks_to_wait) {
+  TickType_t waited = 0;
+
+  while (true) {
+    ssize_t bytes_read = read(STDIN_FILENO, out, 1);
+    if (bytes_read == 1) {
+      return 1;
+    }
+    if (bytes_read < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+        errno != EINTR) {
+      return -1;
+    }
+
+    // Nothing yet (or end of input): poll again on the next tick
+    if (ticks_to_wait != portMAX_DELAY && waited >= ticks_to_wait) {
+      return 0;
+    }
+    vTaskDelay(1);
+    waited++;
+  }
+}
+
+esp_err_t write_raw(const void *data, size_t length) {
+  fflush(stdout);
+
+  const uint8_t *bytes = (const uint8_t *)data;
+  size_t written = 0;
+  while (written < length) {
+    ssize_t result = write(STDOUT_FILENO, bytes + written, length - written);
+    if (result < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      return ESP_FAIL;
+    }
+    written += (size_t)result;
+  }
+  return ESP_OK;
+}
+
+#else
+#include "driver/uart.h"
+#include <stdio.h>
+
 static const uart_port_t UART_PORT = UART_NUM_0;
 
 void configure_uart(void) {
@@ -25,6 +88,19 @@ void configure_uart(void) {
   ESP_ERROR_CHECK(uart_param_config(UART_PORT, &uart_config));
 }
 
+static int read_byte(uint8_t *out, TickType_t ticks_to_wait) {
+  return uart_read_bytes(UART_PORT, out, 1, ticks_to_wait);
+}
+
+esp_err_t write_raw(const void *data, size_t length) {
+  // Whatever stdout still buffers goes out first
+  fflush(stdout);
+  // The driver does no line ending conversion
+  int written = uart_write_bytes(UART_PORT, data, length);
+  return (written == (int)length) ? ESP_OK : ESP_FAIL;
+}
+#endif // CONFIG_IDF_TARGET_LINUX
+
 /**
  * @brief Trim leading and trailing ASCII whitespace from a string.
  *
@@ -46,7 +122,7 @@ void configure_uart(void) {
  * char *trimmed = str_trim(buf);
  * // trimmed -> "hello world"
  */
-static char *str_trim(char *s) {
+char *str_trim(char *s) {
   char *end;
 
   if (s == NULL)
@@ -93,8 +169,7 @@ esp_err_t read_line(char *buf, uint32_t length, TickType_t ticks_to_wait,
 
   // The last byte is reserved for the termination byte
   while (i < length - 1) {
-    int bytes_read =
-        uart_read_bytes(UART_PORT, &character_read, 1, ticks_to_wait);
+    int bytes_read = read_byte(&character_read, ticks_to_wait);
 
     // Handle special cases
     if (bytes_read < 0) {
@@ -120,7 +195,7 @@ esp_err_t read_line(char *buf, uint32_t length, TickType_t ticks_to_wait,
     // Flush rest of overly-long line
     if (i == length - 1) {
       do {
-        int bytes_read = uart_read_bytes(UART_PORT, &character_read, 1, portMAX_DELAY);
+        int bytes_read = read_byte(&character_read, portMAX_DELAY);
         if (bytes_read < 0)
           return ESP_FAIL;
       } while (character_read != '\n' && character_read != '\r');
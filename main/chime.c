@@ -0,0 +1,66 @@
+#include "chime.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+
+// The linux target has no GPIOs, the chime is only logged there
+#if CONFIG_FOCUS_TIMER_CHIME_GPIO >= 0 && !CONFIG_IDF_TARGET_LINUX
+#define CHIME_USE_GPIO 1
+#include "driver/gpio.h"
+#else
+#define CHIME_USE_GPIO 0
+#endif
+
+#define CHIME_TAG "CHIME"
+
+// Alternating on/off durations, starting with "on"
+static const uint32_t PHASE_CHANGED_PATTERN_MS[] = {120, 80, 120};
+static const uint32_t SESSION_FINISHED_PATTERN_MS[] = {300, 150, 300, 150, 600};
+static const uint32_t REMINDER_PATTERN_MS[] = {60};
+
+#define PATTERN_LENGTH(pattern) (sizeof(pattern) / sizeof((pattern)[0]))
+
+static void chime_output(bool on) {
+#if CHIME_USE_GPIO
+  gpio_set_level(CONFIG_FOCUS_TIMER_CHIME_GPIO, on);
+#else
+  ESP_LOGD(CHIME_TAG, "chime %s", on ? "on" : "off");
+#endif
+}
+
+void chime_initialize(void) {
+#if CHIME_USE_GPIO
+  gpio_reset_pin(CONFIG_FOCUS_TIMER_CHIME_GPIO);
+  gpio_set_direction(CONFIG_FOCUS_TIMER_CHIME_GPIO, GPIO_MODE_OUTPUT);
+#endif
+  chime_output(false);
+}
+
+uint32_t chime_job_step(pomodoro_effect_job_t *job) {
+  const uint32_t *pattern;
+  uint32_t length;
+
+  switch (job->effect.type) {
+  case POMODORO_EFFECT_SESSION_FINISHED:
+    pattern = SESSION_FINISHED_PATTERN_MS;
+    length = PATTERN_LENGTH(SESSION_FINISHED_PATTERN_MS);
+    break;
+  case POMODORO_EFFECT_REMINDER:
+    pattern = REMINDER_PATTERN_MS;
+    length = PATTERN_LENGTH(REMINDER_PATTERN_MS);
+    break;
+  case POMODORO_EFFECT_PHASE_CHANGED:
+  default:
+    pattern = PHASE_CHANGED_PATTERN_MS;
+    length = PATTERN_LENGTH(PHASE_CHANGED_PATTERN_MS);
+    break;
+  }
+
+  if (job->cancelled || job->step >= length) {
+    chime_output(false);
+    return EFFECT_JOB_DONE;
+  }
+
+  chime_output(job->step % 2 == 0);
+  return pattern[job->step];
+}
@@ -0,0 +1,17 @@
+#ifndef CHIME_H
+#define CHIME_H
+
+#include "pomodoro_effect_executor.h"
+#include <stdint.h>
+
+void chime_initialize(void);
+
+/*
+ * @brief Effect executor job playing an on/off pattern on the chime output.
+ * The pattern depends on the effect: a short double beep for a phase change,
+ * a long triple beep when the session finishes and a single blip for
+ * reminders.
+ */
+uint32_t chime_job_step(pomodoro_effect_job_t *job);
+
+#endif // CHIME_H
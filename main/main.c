@@ -1,8 +1,16 @@
+#include "chime.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h" // required for pdTICKS_TO_MS and configASSERT
 #include "freertos/queue.h"
+#include "pomodoro_effect_bus.h"
+#include "pomodoro_effect_executor.h"
 #include "pomodoro_fsm.h"
+#include "pomodoro_latency.h"
+#include "pomodoro_query.h"
 #include "pomodoro_reactor_types.h"
+#include "pomodoro_recorder.h"
+#include "pomodoro_stats.h"
 #include "pomodoro_timer.h"
 #include "pomodoro_uart.h"
 #include "uart_task.h"
@@ -10,6 +18,33 @@
 
 #define TAG "MAIN"
 
+#define REACTOR_QUEUE_LENGTH 8
+#define REACTOR_BATCH_QUEUE_LENGTH 4
+
+static void log_effect(void *ctx, const pomodoro_effect_t *effect) {
+  (void)ctx;
+  ESP_LOGD(TAG, "Effect: %s", pomodoro_effect_type_to_string(effect->type));
+}
+
+// Snapshot of the `latency` counters, printed by the UI task
+static ui_latency_report_t
+latency_report(const pomodoro_latency_t *dispatch_latency,
+               const pomodoro_effect_executor_t *executor,
+               uint32_t events_dropped, uint32_t timer_events_stale,
+               uint32_t timer_lock_retries) {
+  const pomodoro_effect_executor_stats_t *stats = &executor->stats;
+  return (ui_latency_report_t){
+      .dispatch = *dispatch_latency,
+      .jobs_submitted = atomic_load(&stats->submitted),
+      .jobs_completed = atomic_load(&stats->completed),
+      .jobs_cancelled = atomic_load(&stats->cancelled),
+      .jobs_dropped = atomic_load(&stats->dropped),
+      .events_dropped = events_dropped,
+      .timer_events_stale = timer_events_stale,
+      .timer_lock_retries = timer_lock_retries,
+  };
+}
+
 void app_main(void) {
   configure_uart();
   ESP_LOGI(TAG, "Focus Timer initialized");
@@ -19,7 +54,7 @@ void app_main(void) {
   const pomodoro_config_t pomodoro_config = {
       .phases =
           {
-              {.name = "Work", .duration_ms = 25 * 1000},
+              {.name = "Work", .duration_ms = 25 * 1000, .focus = true},
               {.name = "Rest", .duration_ms = 5 * 1000},
           },
       .count = 2,
@@ -31,18 +66,48 @@ void app_main(void) {
 
   // === END Finite State Machine initialization ===
 
+  // Event recorder, dumped with the `record` command and replayed on the host
+  static pomodoro_recorder_t recorder;
+  pomodoro_recorder_initialize(&recorder, &session);
+
+  // Statistics, dumped with the `stats` command
+  static pomodoro_stats_t stats;
+  pomodoro_stats_initialize(&stats, &pomodoro_config,
+                            pdTICKS_TO_MS(xTaskGetTickCount()));
+
   // Timestamped atomic queue
-  QueueHandle_t reactor_queue = xQueueCreate(8, sizeof(timestamped_event_t));
+  QueueHandle_t reactor_queue =
+      xQueueCreate(REACTOR_QUEUE_LENGTH, sizeof(timestamped_event_t));
   configASSERT(reactor_queue);
 
+  // UART lines with several commands. Kept apart so that single events stay
+  // small; the set hands both queues' items over in the order they were sent.
+  QueueHandle_t batch_queue =
+      xQueueCreate(REACTOR_BATCH_QUEUE_LENGTH, sizeof(reactor_batch_t));
+  configASSERT(batch_queue);
+
+  QueueSetHandle_t reactor_queue_set =
+      xQueueCreateSet(REACTOR_QUEUE_LENGTH + REACTOR_BATCH_QUEUE_LENGTH);
+  configASSERT(reactor_queue_set);
+  BaseType_t added = xQueueAddToSet(reactor_queue, reactor_queue_set);
+  configASSERT(added == pdPASS);
+  added = xQueueAddToSet(batch_queue, reactor_queue_set);
+  configASSERT(added == pdPASS);
+
+  // Live state for other tasks, published after every transition
+  static pomodoro_query_t live_state;
+  pomodoro_query_initialize(&live_state, &session);
+
   // UART context
   uart_task_context_t uart_task_ctx = {
-      .pomodoro_session = &session,
+      .live_state = &live_state,
       .queue_handle = reactor_queue,
+      .batch_queue_handle = batch_queue,
   };
+  atomic_init(&uart_task_ctx.dropped, 0);
 
-  // UI context
-  ui_context_t ui_task_context;
+  // UI context, too large for the stack (holds a copy of the recorder)
+  static ui_context_t ui_task_context;
   ui_task_initialize(&ui_task_context, &session);
 
   // === START tasks ===
@@ -63,41 +128,195 @@ void app_main(void) {
   xTaskCreate(ui_task, "ui-task", 2048, &ui_task_context, tskIDLE_PRIORITY,
               &ui_task_handle);
 
+  // == EFFECT EXECUTOR ==
+
+  chime_initialize();
+
+  static pomodoro_effect_executor_t effect_executor;
+  pomodoro_effect_executor_initialize(&effect_executor);
+  pomodoro_effect_executor_bind(&effect_executor, POMODORO_EFFECT_PHASE_CHANGED,
+                                chime_job_step, NULL);
+  pomodoro_effect_executor_bind(&effect_executor,
+                                POMODORO_EFFECT_SESSION_FINISHED,
+                                chime_job_step, NULL);
+  pomodoro_effect_executor_bind(&effect_executor, POMODORO_EFFECT_REMINDER,
+                                chime_job_step, NULL);
+
+  TaskHandle_t effect_executor_handle = NULL;
+  xTaskCreate(pomodoro_effect_executor_task, "effect-executor", 2048,
+              &effect_executor, tskIDLE_PRIORITY + 1, &effect_executor_handle);
+
   // === END tasks ===
 
+  // === START effect handlers ===
+
+  static pomodoro_effect_bus_t effect_bus;
+  pomodoro_effect_bus_initialize(&effect_bus);
+
+  pomodoro_err_t register_status = pomodoro_effect_bus_register(
+      &effect_bus, POMODORO_TIMER_EFFECTS_MASK, pomodoro_timer_handle_effect,
+      &pomodoro_timer_context);
+  configASSERT(register_status == POMODORO_STATUS_OK);
+
+  register_status = pomodoro_effect_bus_register(
+      &effect_bus, POMODORO_EFFECT_MASK_ALL, log_effect, NULL);
+  configASSERT(register_status == POMODORO_STATUS_OK);
+
+  register_status = pomodoro_effect_bus_register(
+      &effect_bus, pomodoro_effect_executor_mask(&effect_executor),
+      pomodoro_effect_executor_handle_effect, &effect_executor);
+  configASSERT(register_status == POMODORO_STATUS_OK);
+
+  register_status = pomodoro_effect_bus_register(
+      &effect_bus, UI_EFFECTS_MASK, ui_handle_effect, &ui_task_context);
+  configASSERT(register_status == POMODORO_STATUS_OK);
+
+  // Time from dequeuing an event to having handed all its effects over
+  pomodoro_latency_t dispatch_latency;
+  pomodoro_latency_reset(&dispatch_latency);
+
+  // Timer expiries dropped because their timer was re-armed or stopped
+  uint32_t timer_events_stale = 0;
+
+  // === END effect handlers ===
+
   // === WHILE LOOP - Handlers ===
 
   while (true) {
-    timestamped_event_t timestamped_event;
-    if (!xQueueReceive(reactor_queue, &timestamped_event, portMAX_DELAY)) {
-      // -- No event --
+    // Wakes up at least hourly to keep the statistics' clock well within the
+    // wrap of `now_ms`, see pomodoro_stats_advance()
+    QueueSetMemberHandle_t ready_queue =
+        xQueueSelectFromSet(reactor_queue_set, pdMS_TO_TICKS(STATS_HOUR_MS));
+    if (ready_queue == NULL) {
+      pomodoro_stats_advance(&stats, &session,
+                             pdTICKS_TO_MS(xTaskGetTickCount()));
       continue;
     }
 
-    switch (timestamped_event.type) {
+    // A batch is processed back-to-back, nothing can be interleaved
+    timestamped_event_t unpacked_events[MAX_BATCH_EVENTS];
+    uint32_t unpacked_count = 0;
 
-    case REACTOR_FSM_EVENT: {
-      pomodoro_err_t pomodoro_dispatch_status =
-          pomodoro_session_dispatch(&session, timestamped_event.data.fsm_event,
-                                    timestamped_event.timestamp_ms, &effects);
-
-      if (pomodoro_dispatch_status != POMODORO_STATUS_OK) {
-        const char *status_str =
-            pomodoro_err_to_string(pomodoro_dispatch_status);
-        ESP_LOGW(TAG, "Dispatch failed: %s", status_str);
+    if (ready_queue == batch_queue) {
+      reactor_batch_t received_batch;
+      if (xQueueReceive(batch_queue, &received_batch, 0)) {
+        unpacked_count = reactor_batch_unpack(&received_batch, unpacked_events);
+      }
+    } else if (ready_queue == reactor_queue) {
+      if (xQueueReceive(reactor_queue, &unpacked_events[0], 0)) {
+        unpacked_count = 1;
       }
+    }
 
-      // === Invoke handlers ===
-      pomodoro_timer_handle_effects(&pomodoro_timer_context, &effects);
+    for (uint32_t i = 0; i < unpacked_count; i++) {
+      const timestamped_event_t timestamped_event = unpacked_events[i];
 
-      if (pomodoro_dispatch_status == POMODORO_STATUS_OK) {
-        ui_update_snapshot(&ui_task_context, &session);
-      }
-    } break;
+      switch (timestamped_event.type) {
+
+      case REACTOR_FSM_EVENT: {
+        // Queued before its timer was re-armed or stopped: the session has
+        // moved on, so it is neither dispatched nor recorded
+        if (!pomodoro_timer_is_current(&pomodoro_timer_context,
+                                       &timestamped_event)) {
+          timer_events_stale++;
+          break;
+        }
 
-    case REACTOR_UI_EVENT:
-      ui_request_status(&ui_task_context);
-      break;
+        int64_t dispatch_started_us = esp_timer_get_time();
+        pomodoro_session_t session_before = session;
+
+        pomodoro_err_t pomodoro_dispatch_status = pomodoro_session_dispatch(
+            &session, timestamped_event.data.fsm_event,
+            timestamped_event.timestamp_ms, &effects);
+        // A reminder only emits its REMINDER effect: it neither supersedes
+        // running jobs nor counts as a transition
+        bool session_changed =
+            pomodoro_dispatch_status == POMODORO_STATUS_OK &&
+            !pomodoro_is_reminder_event(timestamped_event.data.fsm_event);
+
+        // === Invoke handlers ===
+        // A rejected event leaves the session and its effects untouched
+        if (session_changed) {
+          pomodoro_effect_executor_supersede(&effect_executor);
+        }
+        if (pomodoro_dispatch_status == POMODORO_STATUS_OK) {
+          pomodoro_effect_bus_dispatch(&effect_bus, &effects);
+        }
+
+        // Recording and logging are not part of the measured window
+        pomodoro_latency_add(
+            &dispatch_latency,
+            (uint32_t)(esp_timer_get_time() - dispatch_started_us));
+
+        pomodoro_recorder_append(&recorder, &timestamped_event,
+                                 pomodoro_dispatch_status);
+
+        if (pomodoro_dispatch_status != POMODORO_STATUS_OK) {
+          const char *status_str =
+              pomodoro_err_to_string(pomodoro_dispatch_status);
+          ESP_LOGW(TAG, "Dispatch failed: %s", status_str);
+        }
+
+        if (session_changed) {
+          pomodoro_stats_on_transition(
+              &stats, &session_before, timestamped_event.data.fsm_event,
+              &session, timestamped_event.timestamp_ms);
+          pomodoro_query_publish(&live_state, &session);
+        }
+      } break;
+
+      case REACTOR_UI_EVENT:
+        pomodoro_recorder_append(&recorder, &timestamped_event,
+                                 POMODORO_STATUS_OK);
+
+        switch (timestamped_event.data.ui_event) {
+        case UI_EVT_STATUS:
+          ui_request_status(&ui_task_context);
+          break;
+        case UI_EVT_DUMP_RECORDING:
+          // Printed by the UI task, the reactor only copies the ring
+          if (!ui_dump_recording(&ui_task_context, &recorder)) {
+            ESP_LOGW(TAG, "Previous recording is still being printed");
+          }
+          break;
+        case UI_EVT_LATENCY: {
+          // Printed by the UI task, outside of the loop being measured
+          ui_latency_report_t report = latency_report(
+              &dispatch_latency, &effect_executor,
+              atomic_load(&uart_task_ctx.dropped) +
+                  atomic_load(&pomodoro_timer_context.dropped),
+              timer_events_stale,
+              atomic_load(&pomodoro_timer_context.lock_retries));
+          if (!ui_print_latency(&ui_task_context, &report)) {
+            ESP_LOGW(TAG, "Previous latency report is still being printed");
+          }
+        } break;
+        case UI_EVT_STATS:
+          pomodoro_stats_advance(&stats, &session,
+                                 pdTICKS_TO_MS(xTaskGetTickCount()));
+          // Printed by the UI task, like the recording
+          if (!ui_dump_stats(&ui_task_context, &stats)) {
+            ESP_LOGW(TAG, "Previous stats are still being printed");
+          }
+          break;
+        case UI_EVT_TELEMETRY_TEXT:
+          ui_set_telemetry(&ui_task_context, 0);
+          break;
+        case UI_EVT_TELEMETRY_BINARY_1HZ:
+          ui_set_telemetry(&ui_task_context, 1000);
+          break;
+        case UI_EVT_TELEMETRY_BINARY_4HZ:
+          ui_set_telemetry(&ui_task_context, 250);
+          break;
+        case UI_EVT_TELEMETRY_BINARY_10HZ:
+          ui_set_telemetry(&ui_task_context, 100);
+          break;
+        case UI_EVT_COUNT:
+          // Not an event, only bounds the enum
+          break;
+        }
+        break;
+      }
     }
   }
 }
@@ -3,6 +3,9 @@
 #include "pomodoro_reactor_types.h"
 #include "pomodoro_uart.h"
 #include "string.h"
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
 
 static bool handle_command(const char *cmd, timestamped_event_t *event_ptr,
                            uint32_t now_ms) {
@@ -41,6 +44,41 @@ static bool handle_command(const char *cmd, timestamped_event_t *event_ptr,
     event_ptr->data.ui_event = UI_EVT_STATUS;
   }
 
+  else if (strcmp(cmd, "record") == 0) {
+    event_ptr->type = REACTOR_UI_EVENT;
+    event_ptr->data.ui_event = UI_EVT_DUMP_RECORDING;
+  }
+
+  else if (strcmp(cmd, "latency") == 0) {
+    event_ptr->type = REACTOR_UI_EVENT;
+    event_ptr->data.ui_event = UI_EVT_LATENCY;
+  }
+
+  else if (strcmp(cmd, "stats") == 0) {
+    event_ptr->type = REACTOR_UI_EVENT;
+    event_ptr->data.ui_event = UI_EVT_STATS;
+  }
+
+  else if (strcmp(cmd, "telemetry text") == 0) {
+    event_ptr->type = REACTOR_UI_EVENT;
+    event_ptr->data.ui_event = UI_EVT_TELEMETRY_TEXT;
+  }
+
+  else if (strcmp(cmd, "telemetry 1hz") == 0) {
+    event_ptr->type = REACTOR_UI_EVENT;
+    event_ptr->data.ui_event = UI_EVT_TELEMETRY_BINARY_1HZ;
+  }
+
+  else if (strcmp(cmd, "telemetry 4hz") == 0) {
+    event_ptr->type = REACTOR_UI_EVENT;
+    event_ptr->data.ui_event = UI_EVT_TELEMETRY_BINARY_4HZ;
+  }
+
+  else if (strcmp(cmd, "telemetry 10hz") == 0) {
+    event_ptr->type = REACTOR_UI_EVENT;
+    event_ptr->data.ui_event = UI_EVT_TELEMETRY_BINARY_10HZ;
+  }
+
   else {
     return false;
   }
@@ -49,9 +87,127 @@ static bool handle_command(const char *cmd, timestamped_event_t *event_ptr,
   return true;
 }
 
+static uart_macro_t macros[UART_MAX_MACROS];
+
+static uart_macro_t *find_macro(const char *name) {
+  for (uint32_t i = 0; i < UART_MAX_MACROS; i++) {
+    if (macros[i].name[0] != '\0' && strcmp(macros[i].name, name) == 0) {
+      return &macros[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+ * @brief Parses `cmd;cmd;...` into `batch`. Macros are expanded in place.
+ * Nothing is kept on error, so a bad line is never half-applied.
+ */
+static bool parse_sequence(char *sequence, reactor_batch_t *batch,
+                           uint32_t now_ms) {
+  reactor_batch_initialize(batch, now_ms);
+
+  char *save_ptr = NULL;
+  for (char *token = strtok_r(sequence, ";", &save_ptr); token != NULL;
+       token = strtok_r(NULL, ";", &save_ptr)) {
+    char *cmd = str_trim(token);
+    if (strlen(cmd) == 0)
+      continue;
+
+    timestamped_event_t event;
+    const uart_macro_t *macro = find_macro(cmd);
+    bool appended;
+
+    if (macro != NULL) {
+      appended = reactor_batch_append_batch(batch, &macro->batch);
+    } else if (handle_command(cmd, &event, now_ms)) {
+      appended = reactor_batch_append(batch, &event);
+    } else {
+      ESP_LOGW(UART_TAG, "Unknown command: %s", cmd);
+      return false;
+    }
+
+    if (!appended) {
+      ESP_LOGW(UART_TAG, "Sequence longer than %d commands", MAX_BATCH_EVENTS);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static bool is_valid_macro_name(const char *name) {
+  size_t length = strlen(name);
+  if (length == 0 || length >= UART_MACRO_NAME_SIZE) {
+    return false;
+  }
+  for (size_t i = 0; i < length; i++) {
+    if (!isalnum((unsigned char)name[i]) && name[i] != '_' && name[i] != '-') {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * @brief Handles `name = cmd;cmd;...`. An empty body deletes the macro.
+ */
+static void define_macro(char *line, char *equals_ptr) {
+  *equals_ptr = '\0';
+  char *name = str_trim(line);
+  char *body = str_trim(equals_ptr + 1);
+
+  timestamped_event_t builtin;
+  if (!is_valid_macro_name(name) || handle_command(name, &builtin, 0) ||
+      strcmp(name, "query") == 0) {
+    ESP_LOGW(UART_TAG, "Invalid macro name: %s", name);
+    return;
+  }
+
+  uart_macro_t *macro = find_macro(name);
+
+  if (strlen(body) == 0) {
+    if (macro != NULL) {
+      macro->name[0] = '\0';
+    }
+    return;
+  }
+
+  // Parse into a scratch batch first: a failed redefinition keeps the old one
+  reactor_batch_t batch;
+  if (!parse_sequence(body, &batch, 0)) {
+    return;
+  }
+
+  if (macro == NULL) {
+    for (uint32_t i = 0; i < UART_MAX_MACROS && macro == NULL; i++) {
+      if (macros[i].name[0] == '\0') {
+        macro = &macros[i];
+      }
+    }
+  }
+  if (macro == NULL) {
+    ESP_LOGW(UART_TAG, "No room for more than %d macros", UART_MAX_MACROS);
+    return;
+  }
+
+  strcpy(macro->name, name);
+  macro->batch = batch;
+}
+
+static void print_live_state(const pomodoro_query_t *live_state) {
+  uint32_t now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+  pomodoro_live_state_t state;
+  pomodoro_query_state(live_state, now_ms, &state);
+
+  printf("query now_ms=%" PRIu32 " state=\"%s\" current_phase=\"%s\""
+         " time_remaining_ms=%" PRIu32 " generation=%" PRIu32 "\n",
+         now_ms, pomodoro_state_to_string(state.state), state.phase_name,
+         state.remaining_ms, state.generation);
+}
+
 void uart_task(void *args) {
   uart_task_context_t *ctx = (uart_task_context_t *)args;
-  timestamped_event_t timestamped_event;
+  reactor_batch_t batch;
 
   char uart_buffer[UART_BUFFER_SIZE];
   char *trimmed_ptr;
@@ -67,14 +223,42 @@ void uart_task(void *args) {
     if (strlen(trimmed_ptr) == 0)
       continue;
 
-    bool was_command_detected = handle_command(
-        trimmed_ptr, &timestamped_event, pdTICKS_TO_MS(xTaskGetTickCount()));
+    // Read straight from the published state, the reactor is not involved
+    if (strcmp(trimmed_ptr, "query") == 0) {
+      print_live_state(ctx->live_state);
+      continue;
+    }
+
+    char *equals_ptr = strchr(trimmed_ptr, '=');
+    if (equals_ptr != NULL) {
+      define_macro(trimmed_ptr, equals_ptr);
+      continue;
+    }
 
-    if (!was_command_detected) {
-      ESP_LOGW(UART_TAG, "Unknown command: %s", trimmed_ptr);
+    if (!parse_sequence(trimmed_ptr, &batch,
+                        pdTICKS_TO_MS(xTaskGetTickCount()))) {
       continue;
     }
 
-    xQueueSend(ctx->queue_handle, &timestamped_event, 0);
+    // The whole line is a single queue item, so it reaches the reactor
+    // atomically
+    BaseType_t sent;
+    switch (batch.count) {
+    case 0:
+      continue;
+    case 1: {
+      timestamped_event_t single[MAX_BATCH_EVENTS];
+      reactor_batch_unpack(&batch, single);
+      sent = xQueueSend(ctx->queue_handle, &single[0], 0);
+    } break;
+    default:
+      sent = xQueueSend(ctx->batch_queue_handle, &batch, 0);
+      break;
+    }
+
+    if (sent != pdTRUE) {
+      atomic_fetch_add(&ctx->dropped, 1);
+      ESP_LOGW(UART_TAG, "Reactor queue full, line dropped");
+    }
   }
-}
\ No newline at end of file
+}
@@ -4,13 +4,28 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "pomodoro_fsm.h"
+#include "pomodoro_query.h"
+#include "pomodoro_reactor_types.h"
+#include <stdatomic.h>
 
 #define UART_TAG "UART_TAG"
 #define UART_BUFFER_SIZE 200
 
+#define UART_MAX_MACROS 8
+#define UART_MACRO_NAME_SIZE 16
+
+typedef struct uart_macro {
+  char name[UART_MACRO_NAME_SIZE]; // Empty when the slot is free
+  reactor_batch_t batch;           // Commands, already parsed
+} uart_macro_t;
+
 typedef struct uart_task_context {
-  const pomodoro_session_t *pomodoro_session;
-  QueueHandle_t queue_handle;
+  // Answers `query` without a round trip through the reactor
+  const pomodoro_query_t *live_state;
+  QueueHandle_t queue_handle;       // timestamped_event_t
+  QueueHandle_t batch_queue_handle; // reactor_batch_t, see `reactor_batch_t`
+  // Lines lost because the reactor queue was full, read by the reactor
+  _Atomic uint32_t dropped;
 } uart_task_context_t;
 
 void uart_task(void *args);
@@ -1,7 +1,9 @@
 #include "ui_task.h"
 #include "esp_log.h"
+#include "esp_system.h"
 #include "freertos/projdefs.h"
 #include "pomodoro_fsm.h"
+#include "pomodoro_uart.h"
 #include "portmacro.h"
 #include <inttypes.h>
 #include <stdint.h>
@@ -11,24 +13,75 @@
 #define UI_UPDATE_INTERVAL_MS 1000
 
 void ui_task_initialize(ui_context_t *ui_context,
-                        const ui_fsm_snapshot_t *first_snapshot) {
+                        const pomodoro_session_t *session) {
   ui_context->queue = xQueueCreate(1, sizeof(ui_task_event_t));
   configASSERT(ui_context->queue);
 
-  memcpy(&ui_context->snapshot, first_snapshot, sizeof(ui_fsm_snapshot_t));
+  ui_context->session = session;
+  ui_context->transitions = 0;
+  ui_context->snapshot = (ui_fsm_snapshot_t){
+      .session = *session,
+      .transitions = 0,
+  };
+
+  atomic_init(&ui_context->telemetry_interval_ms, 0);
+  pomodoro_telemetry_encoder_initialize(&ui_context->telemetry_encoder,
+                                        UI_UPDATE_INTERVAL_MS,
+                                        UI_TELEMETRY_KEYFRAME_EVERY);
+  atomic_init(&ui_context->recording_pending, false);
+  atomic_init(&ui_context->stats_pending, false);
+  atomic_init(&ui_context->latency_pending, false);
+}
+
+static void write_telemetry_record(ui_context_t *ctx, uint32_t now_ms) {
+  const pomodoro_session_t *session = &ctx->snapshot.session;
+
+  pomodoro_telemetry_sample_t sample = {
+      .timestamp_ms = now_ms,
+      .state = (uint8_t)session->state,
+      .phase_index = session->phase_index,
+      .remaining_ms = pomodoro_time_remaining_ms(session, now_ms),
+      .transitions = ctx->snapshot.transitions,
+  };
+
+  size_t length =
+      pomodoro_telemetry_encode(&ctx->telemetry_encoder, &sample,
+                                ctx->telemetry_frame,
+                                sizeof(ctx->telemetry_frame));
+
+  // Not through stdout: it would add a '\r' before any 0x0A byte of the frame
+  if (write_raw(ctx->telemetry_frame, length) != ESP_OK) {
+    ESP_LOGW(UI_TAG, "Telemetry frame not written");
+  }
+}
+
+static void print_latency(const ui_latency_report_t *report) {
+  const pomodoro_latency_t *dispatch = &report->dispatch;
+  printf("dispatch_us_min=%" PRIu32 " dispatch_us_avg=%" PRIu32
+         " dispatch_us_max=%" PRIu32 " dispatches=%" PRIu32
+         " jobs_submitted=%" PRIu32 " jobs_completed=%" PRIu32
+         " jobs_cancelled=%" PRIu32 " jobs_dropped=%" PRIu32
+         " events_dropped=%" PRIu32 " heap_free_min=%" PRIu32
+         " timer_events_stale=%" PRIu32 " timer_lock_retries=%" PRIu32 "\n",
+         dispatch->count ? dispatch->min_us : 0,
+         pomodoro_latency_average_us(dispatch), dispatch->max_us,
+         dispatch->count, report->jobs_submitted, report->jobs_completed,
+         report->jobs_cancelled, report->jobs_dropped, report->events_dropped,
+         esp_get_minimum_free_heap_size(), report->timer_events_stale,
+         report->timer_lock_retries);
 }
 
 static void print_snapshot(ui_context_t *ctx, uint32_t now_ms) {
   const size_t PRINT_BUFFER_SIZE = sizeof(ctx->print_buffer);
-  const ui_fsm_snapshot_t *snapshot = &ctx->snapshot;
+  const pomodoro_session_t *session = &ctx->snapshot.session;
 
   int required = snprintf(
       ctx->print_buffer, PRINT_BUFFER_SIZE,
       "now_ms=%" PRIu32
       " state=\"%s\" current_phase=\"%s\" time_remaining_ms=%" PRIu32 "\n",
-      now_ms, pomodoro_state_to_string(snapshot->state),
-      pomodoro_current_phase(snapshot)->name,
-      pomodoro_time_remaining_ms(snapshot, now_ms));
+      now_ms, pomodoro_state_to_string(session->state),
+      pomodoro_current_phase(session)->name,
+      pomodoro_time_remaining_ms(session, now_ms));
 
   if (required < 0) {
     ESP_LOGW(UI_TAG, "There has been an encoding problem");
@@ -47,15 +100,23 @@ void ui_task(void *args) {
   ui_task_event_t event;
   uint32_t now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
 
+  uint32_t telemetry_interval_ms = 0;
+
   while (true) {
+    uint32_t update_interval_ms = telemetry_interval_ms > 0
+                                      ? telemetry_interval_ms
+                                      : UI_UPDATE_INTERVAL_MS;
     TickType_t queue_receive_timeout =
-        context->snapshot.state == POMODORO_STATE_RUNNING
-            ? pdMS_TO_TICKS(UI_UPDATE_INTERVAL_MS)
+        context->snapshot.session.state == POMODORO_STATE_RUNNING
+            ? pdMS_TO_TICKS(update_interval_ms)
             : portMAX_DELAY;
 
     if (xQueueReceive(context->queue, &event, queue_receive_timeout)) {
       switch (event.type) {
       case PRINT_STATUS:
+      case DUMP_RECORDING:
+      case DUMP_STATS:
+      case PRINT_LATENCY:
         break; // Don't do anything special
       case UPDATE_SNAPSHOT:
         // Update snapshot
@@ -65,21 +126,108 @@ void ui_task(void *args) {
       }
     }
 
+    // Also set when the wake-up got merged with another event
+    if (atomic_load(&context->recording_pending)) {
+      pomodoro_recorder_dump(&context->recording, stdout);
+      atomic_store(&context->recording_pending, false);
+    }
+    if (atomic_load(&context->stats_pending)) {
+      pomodoro_stats_dump(&context->stats, stdout);
+      atomic_store(&context->stats_pending, false);
+    }
+    if (atomic_load(&context->latency_pending)) {
+      print_latency(&context->latency);
+      atomic_store(&context->latency_pending, false);
+    }
+
+    // Send a keyframe with the new interval whenever the rate changes. The
+    // sequence counter carries on, so decoders see no gap.
+    uint32_t requested_interval_ms =
+        atomic_load(&context->telemetry_interval_ms);
+    if (requested_interval_ms != telemetry_interval_ms) {
+      telemetry_interval_ms = requested_interval_ms;
+      pomodoro_telemetry_encoder_reset(&context->telemetry_encoder,
+                                       telemetry_interval_ms);
+    }
+
     now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
-    print_snapshot(context, now_ms);
+    if (telemetry_interval_ms > 0) {
+      write_telemetry_record(context, now_ms);
+    } else {
+      print_snapshot(context, now_ms);
+    }
   }
 }
 
-void ui_update_snapshot(const ui_context_t *ctx,
-                        const ui_fsm_snapshot_t *new_snapshot) {
+void ui_handle_effect(void *ctx, const pomodoro_effect_t *effect) {
+  ui_context_t *context = (ui_context_t *)ctx;
+  (void)effect;
+
+  // The bus only sees successful transitions, and SESSION_UPDATED once each
+  context->transitions++;
+
   ui_task_event_t event = {
       .type = UPDATE_SNAPSHOT,
-      .data.snapshot = *new_snapshot,
+      .data.snapshot =
+          {
+              .session = *context->session,
+              .transitions = context->transitions,
+          },
   };
-  xQueueOverwrite(ctx->queue, &event);
+  // The counter is cumulative, so a replaced snapshot loses nothing
+  xQueueOverwrite(context->queue, &event);
 }
 
 void ui_request_status(const ui_context_t *ctx) {
+  // Every wake-up prints, so when the queue is full the pending item already
+  // takes care of it
   ui_task_event_t event = {.type = PRINT_STATUS};
-  xQueueOverwrite(ctx->queue, &event);
+  xQueueSend(ctx->queue, &event, 0);
+}
+
+void ui_set_telemetry(ui_context_t *ctx, uint32_t interval_ms) {
+  atomic_store(&ctx->telemetry_interval_ms, interval_ms);
+  // Wake the UI task so the switch is immediate
+  ui_request_status(ctx);
+}
+
+bool ui_dump_recording(ui_context_t *ctx, const pomodoro_recorder_t *recorder) {
+  if (atomic_load(&ctx->recording_pending)) {
+    return false;
+  }
+
+  memcpy(&ctx->recording, recorder, sizeof(pomodoro_recorder_t));
+  atomic_store(&ctx->recording_pending, true);
+
+  // Never overwrites a pending snapshot. When the queue is full, the task is
+  // about to wake up anyway and will see the flag.
+  ui_task_event_t event = {.type = DUMP_RECORDING};
+  xQueueSend(ctx->queue, &event, 0);
+  return true;
+}
+
+bool ui_dump_stats(ui_context_t *ctx, const pomodoro_stats_t *stats) {
+  if (atomic_load(&ctx->stats_pending)) {
+    return false;
+  }
+
+  pomodoro_stats_copy(&ctx->stats, stats);
+  atomic_store(&ctx->stats_pending, true);
+
+  ui_task_event_t event = {.type = DUMP_STATS};
+  xQueueSend(ctx->queue, &event, 0);
+  return true;
+}
+
+bool ui_print_latency(ui_context_t *ctx, const ui_latency_report_t *report) {
+  if (atomic_load(&ctx->latency_pending)) {
+    return false;
+  }
+
+  ctx->latency = *report;
+  atomic_store(&ctx->latency_pending, true);
+
+  ui_task_event_t event = {.type = PRINT_LATENCY};
+  xQueueSend(ctx->queue, &event, 0);
+  return true;
 }
@@ -1,14 +1,42 @@
 #ifndef UI_TASK_H
 #define UI_TASK_H
 
+#include "pomodoro_effect_bus.h"
 #include "pomodoro_fsm.h"
+#include "pomodoro_latency.h"
+#include "pomodoro_recorder.h"
+#include "pomodoro_stats.h"
+#include "pomodoro_telemetry.h"
 #include <freertos/FreeRTOS.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 
-typedef pomodoro_session_t ui_fsm_snapshot_t;
+typedef struct ui_fsm_snapshot {
+  pomodoro_session_t session;
+  uint32_t transitions; // Since boot, counted on the reactor side
+} ui_fsm_snapshot_t;
+
+// Counters printed by the `latency` command, copied from the reactor
+typedef struct ui_latency_report {
+  pomodoro_latency_t dispatch;
+  uint32_t jobs_submitted;
+  uint32_t jobs_completed;
+  uint32_t jobs_cancelled;
+  uint32_t jobs_dropped;
+  uint32_t events_dropped;
+  uint32_t timer_events_stale;
+  uint32_t timer_lock_retries;
+} ui_latency_report_t;
 
 typedef enum ui_task_event_type {
   UPDATE_SNAPSHOT,
   PRINT_STATUS,
+  // Wakes the task to print `ui_context_t.recording`
+  DUMP_RECORDING,
+  // Wakes the task to print `ui_context_t.stats`
+  DUMP_STATS,
+  // Wakes the task to print `ui_context_t.latency`
+  PRINT_LATENCY,
 } ui_task_event_type_t;
 
 typedef struct ui_task_event {
@@ -18,20 +46,79 @@ typedef struct ui_task_event {
   } data;
 } ui_task_event_t;
 
+// Binary telemetry: records between keyframes
+#define UI_TELEMETRY_KEYFRAME_EVERY 10
+
 typedef struct ui_context {
   QueueHandle_t queue;
+  // Reactor side, only touched by `ui_handle_effect`: the reactor's session
+  // and the transitions seen so far
+  const pomodoro_session_t *session;
+  uint32_t transitions;
+
+  // UI task side
   ui_fsm_snapshot_t snapshot;
   char print_buffer[512];
+
+  // 0: human-readable text lines, otherwise binary records at this interval
+  atomic_uint_fast32_t telemetry_interval_ms;
+  pomodoro_telemetry_encoder_t telemetry_encoder;
+  uint8_t telemetry_frame[POMODORO_TELEMETRY_MAX_FRAME];
+
+  // Copy of the recorder, owned by the UI task while `recording_pending`
+  pomodoro_recorder_t recording;
+  atomic_bool recording_pending;
+
+  // Copy of the statistics, owned by the UI task while `stats_pending`
+  pomodoro_stats_t stats;
+  atomic_bool stats_pending;
+
+  // Copy of the latency counters, owned by the UI task while `latency_pending`
+  ui_latency_report_t latency;
+  atomic_bool latency_pending;
 } ui_context_t;
 
 void ui_task_initialize(ui_context_t *ui_context,
-                        const ui_fsm_snapshot_t *first_snapshot);
+                        const pomodoro_session_t *session);
 
 void ui_task(void *args);
 
-void ui_update_snapshot(const ui_context_t *ctx,
-                        const ui_fsm_snapshot_t *new_snapshot);
+// Effect types `ui_handle_effect` acts upon
+#define UI_EFFECTS_MASK POMODORO_EFFECT_MASK(POMODORO_EFFECT_SESSION_UPDATED)
+
+/*
+ * @brief Effect bus handler, `ctx` is a `ui_context_t`. Counts the transition
+ * and sends the UI task a snapshot of the session. A newer snapshot replaces
+ * one the task has not picked up yet.
+ */
+void ui_handle_effect(void *ctx, const pomodoro_effect_t *effect);
 
+/*
+ * @brief Prints the current snapshot. Never replaces a pending snapshot.
+ */
 void ui_request_status(const ui_context_t *ctx);
 
+/*
+ * @brief Switches between text output (`interval_ms == 0`) and binary
+ * telemetry records every `interval_ms` while running.
+ */
+void ui_set_telemetry(ui_context_t *ctx, uint32_t interval_ms);
+
+/*
+ * @brief Copies `recorder` and lets the UI task print it, so the caller does
+ * not block on the console. Returns false while a previous dump is still being
+ * printed.
+ */
+bool ui_dump_recording(ui_context_t *ctx, const pomodoro_recorder_t *recorder);
+
+/*
+ * @brief Same as ui_dump_recording() for the statistics. Advance them first.
+ */
+bool ui_dump_stats(ui_context_t *ctx, const pomodoro_stats_t *stats);
+
+/*
+ * @brief Same as ui_dump_recording() for the `latency` counters.
+ */
+bool ui_print_latency(ui_context_t *ctx, const ui_latency_report_t *report);
+
 #endif // UI_TASK_H
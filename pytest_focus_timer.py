@@ -0,0 +1,326 @@
+"""End-to-end regression suite for the focus timer firmware.
+
+Drives the real UART command interface and fails when a measurement regresses
+beyond the thresholds below. Build the app for the target first, then:
+
+    # QEMU
+    idf.py set-target esp32 build
+    pytest --embedded-services idf,qemu --target esp32
+
+    # linux target (commands go through stdin)
+    idf.py --preview set-target linux build
+    pytest --embedded-services idf --target linux
+
+FOCUS_TIMER_SEQUENCES and FOCUS_TIMER_SEED change the size and the input of
+the command load.
+
+Besides the fixed ceilings, each target's measurements are compared with the
+ones recorded in pytest_focus_timer_baseline.json, with a relative tolerance.
+A target without a recorded baseline is only held to the ceilings. Record or
+refresh a baseline (after a deliberate change) with:
+
+    FOCUS_TIMER_UPDATE_BASELINE=1 pytest --embedded-services idf,qemu --target esp32
+"""
+import json
+import logging
+import os
+import random
+import re
+import statistics
+import time
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, List, Tuple
+
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+from pytest_embedded_idf.utils import idf_parametrize
+
+# === Regression thresholds ===
+
+# Host-side round trip from sending a command line to reading its result back
+# (the `latency` acknowledgement, then `query`)
+MAX_COMMAND_LATENCY_P95_MS = 250.0
+# Reactor time per FSM event, as reported by `latency`
+MAX_DISPATCH_US = 2000
+# Lateness of a phase end, measured on the device clock
+MAX_PHASE_ERROR_MS = 50
+MAX_DROPPED_EVENTS = 0
+# Sequences whose resulting state differs from the host-side model. A phase
+# may legitimately time out between two commands, so a few are tolerated.
+MAX_MODEL_DIVERGENCE_RATIO = 0.01
+# Real chips only: the linux target reports the host's heap
+MIN_FREE_HEAP_BYTES = 100 * 1024
+
+# === Baseline ===
+
+BASELINE_PATH = Path(__file__).with_name('pytest_focus_timer_baseline.json')
+UPDATE_BASELINE = os.getenv('FOCUS_TIMER_UPDATE_BASELINE') == '1'
+# A measurement regresses when it exceeds baseline * (1 + tolerance) + slack.
+# The slack keeps near-zero baselines from failing on noise.
+BASELINE_TOLERANCE = 0.25
+BASELINE_SLACK = {
+    'latency_p95_ms': 5.0,
+    'dispatch_us_max': 50.0,
+    'phase_error_ms': 5.0,
+}
+
+SEQUENCES = int(os.getenv('FOCUS_TIMER_SEQUENCES', '2000'))
+SEED = int(os.getenv('FOCUS_TIMER_SEED', '1'))
+
+# Schedule built into main.c
+PHASES = [('Work', 25_000), ('Rest', 5_000)]
+
+# Weighted towards the commands that exercise the timer
+COMMANDS = ['start', 'pause', 'resume', 'skip'] * 3 + ['restart']
+
+QUERY_RE = re.compile(
+    rb'query now_ms=(\d+) state="(\w+)" current_phase="([^"]*)" time_remaining_ms=(\d+) generation=(\d+)'
+)
+LATENCY_RE = re.compile(
+    rb'dispatch_us_min=(\d+) dispatch_us_avg=(\d+) dispatch_us_max=(\d+) dispatches=(\d+)'
+    rb'.* events_dropped=(\d+) heap_free_min=(\d+)'
+)
+
+
+@dataclass
+class Status:
+    now_ms: int
+    state: str
+    phase: str
+    remaining_ms: int
+
+    @property
+    def end_time_ms(self) -> int:
+        return self.now_ms + self.remaining_ms
+
+
+@dataclass
+class Latency:
+    dispatch_us_max: int
+    dispatches: int
+    events_dropped: int
+    heap_free_min: int
+
+
+class SessionModel:
+    """Mirror of pomodoro_session_dispatch() for the user commands."""
+
+    def __init__(self) -> None:
+        self.restart()
+
+    def restart(self) -> None:
+        self.state = 'IDLE'
+        self.phase_index = 0
+
+    def skip(self) -> None:
+        if self.phase_index + 1 < len(PHASES):
+            self.phase_index += 1
+            self.state = 'RUNNING'
+        else:
+            self.state = 'FINISHED'
+
+    def apply(self, command: str) -> None:
+        if command == 'restart':
+            self.restart()
+        elif command == 'start' and self.state == 'IDLE':
+            self.state = 'RUNNING'
+        elif command == 'pause' and self.state == 'RUNNING':
+            self.state = 'PAUSED'
+        elif command == 'resume' and self.state == 'PAUSED':
+            self.state = 'RUNNING'
+        elif command == 'skip' and self.state in ('RUNNING', 'PAUSED'):
+            self.skip()
+
+    @property
+    def phase(self) -> str:
+        return PHASES[self.phase_index][0]
+
+    def resync(self, state: str, phase: str) -> None:
+        self.state = state
+        self.phase_index = [name for name, _ in PHASES].index(phase)
+
+
+def send(dut: IdfDut, line: str) -> None:
+    # An extra newline is harmless: the firmware skips empty lines
+    dut.write(line + '\n')
+
+
+def query(dut: IdfDut) -> Tuple[str, str, int]:
+    send(dut, 'query')
+    match = dut.expect(QUERY_RE, timeout=5)
+    return match.group(2).decode(), match.group(3).decode(), int(match.group(5))
+
+
+def read_latency(dut: IdfDut) -> Latency:
+    send(dut, 'latency')
+    match = dut.expect(LATENCY_RE, timeout=5)
+    return Latency(
+        dispatch_us_max=int(match.group(3)),
+        dispatches=int(match.group(4)),
+        events_dropped=int(match.group(5)),
+        heap_free_min=int(match.group(6)),
+    )
+
+
+def expect_status(dut: IdfDut, state: str, phase: str, timeout: float) -> Status:
+    pattern = re.compile(
+        rb'^now_ms=(\d+) state="' + state.encode() + rb'" current_phase="' + phase.encode() + rb'" '
+        rb'time_remaining_ms=(\d+)',
+        re.MULTILINE,
+    )
+    match = dut.expect(pattern, timeout=timeout)
+    return Status(int(match.group(1)), state, phase, int(match.group(2)))
+
+
+def wait_for_boot(dut: IdfDut) -> None:
+    dut.expect('Focus Timer initialized', timeout=60)
+    send(dut, 'restart')
+    query(dut)
+
+
+def percentile(values: List[float], fraction: float) -> float:
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def load_baselines() -> Dict[str, Dict[str, float]]:
+    if not BASELINE_PATH.exists():
+        return {}
+    with BASELINE_PATH.open() as baseline_file:
+        return json.load(baseline_file)
+
+
+def check_baseline(target: str, measured: Dict[str, float]) -> None:
+    """Compares `measured` (keys of BASELINE_SLACK) with the target's baseline,
+    or records it with FOCUS_TIMER_UPDATE_BASELINE=1."""
+    baselines = load_baselines()
+    recorded = baselines.setdefault(target, {})
+
+    if UPDATE_BASELINE:
+        recorded.update(measured)
+        with BASELINE_PATH.open('w') as baseline_file:
+            json.dump(baselines, baseline_file, indent=2, sort_keys=True)
+            baseline_file.write('\n')
+        logging.info(f'baseline for {target} updated: {measured}')
+        return
+
+    for name, value in measured.items():
+        if name not in recorded:
+            logging.warning(f'no baseline for {target} {name}, only the ceilings apply')
+            continue
+        allowed = recorded[name] * (1 + BASELINE_TOLERANCE) + BASELINE_SLACK[name]
+        assert value <= allowed, f'{name}={value} regressed from the baseline {recorded[name]} (allowed {allowed:.1f})'
+
+
+# === Scenarios ===
+
+
+def run_command_load(dut: IdfDut, target: str) -> None:
+    wait_for_boot(dut)
+    before = read_latency(dut)
+
+    rng = random.Random(SEED)
+    model = SessionModel()
+    latencies_ms: List[float] = []
+    commands_sent = 0
+    divergences = 0
+    last_generation = -1
+
+    for _ in range(SEQUENCES):
+        sequence = [rng.choice(COMMANDS) for _ in range(rng.randint(1, 4))]
+        if model.state == 'FINISHED':
+            sequence.insert(0, 'restart')
+
+        started = time.perf_counter()
+        send(dut, ';'.join(sequence))
+        # `query` is answered by the UART task and could overtake the reactor.
+        # The reactor handles `latency` after the line above, and its report
+        # is printed only once the line has been dispatched and published.
+        read_latency(dut)
+        state, phase, generation = query(dut)
+        latencies_ms.append((time.perf_counter() - started) * 1000)
+
+        commands_sent += len(sequence)
+        for command in sequence:
+            model.apply(command)
+
+        assert generation >= last_generation, 'published state went back in time'
+        last_generation = generation
+
+        if (state, phase) != (model.state, model.phase):
+            divergences += 1
+            model.resync(state, phase)
+
+    after = read_latency(dut)
+    dispatches = after.dispatches - before.dispatches
+    p50 = statistics.median(latencies_ms)
+    p95 = percentile(latencies_ms, 0.95)
+
+    logging.info(
+        f'sequences={SEQUENCES} commands={commands_sent} dispatches={dispatches} '
+        f'latency_p50_ms={p50:.1f} latency_p95_ms={p95:.1f} latency_max_ms={max(latencies_ms):.1f} '
+        f'dispatch_us_max={after.dispatch_us_max} events_dropped={after.events_dropped} '
+        f'divergences={divergences} heap_free_min={after.heap_free_min}'
+    )
+
+    assert p95 <= MAX_COMMAND_LATENCY_P95_MS, f'command latency p95 {p95:.1f} ms'
+    assert after.dispatch_us_max <= MAX_DISPATCH_US, f'dispatch took {after.dispatch_us_max} us'
+    assert after.events_dropped <= MAX_DROPPED_EVENTS, f'{after.events_dropped} events dropped'
+    # Every command reached the FSM, whether or not it was a valid transition
+    assert dispatches >= commands_sent, f'{commands_sent - dispatches} commands lost'
+    assert divergences <= MAX_MODEL_DIVERGENCE_RATIO * SEQUENCES, f'{divergences} sequences diverged'
+    if target != 'linux':
+        assert after.heap_free_min >= MIN_FREE_HEAP_BYTES, f'free heap went down to {after.heap_free_min}'
+
+    check_baseline(target, {'latency_p95_ms': round(p95, 1), 'dispatch_us_max': after.dispatch_us_max})
+
+
+def run_phase_accuracy(dut: IdfDut, target: str) -> None:
+    wait_for_boot(dut)
+    (work, work_ms), (rest, rest_ms) = PHASES
+
+    send(dut, 'start')
+    started = expect_status(dut, 'RUNNING', work, timeout=5)
+    # The first status of the next phase tells when it began: its end time
+    # minus its duration
+    next_phase = expect_status(dut, 'RUNNING', rest, timeout=work_ms / 1000 + 10)
+
+    work_started_ms = started.end_time_ms - work_ms
+    work_ended_ms = next_phase.end_time_ms - rest_ms
+    error_ms = (work_ended_ms - work_started_ms) - work_ms
+
+    logging.info(f'phase={work} expected_ms={work_ms} measured_ms={work_ended_ms - work_started_ms}')
+    assert 0 <= error_ms <= MAX_PHASE_ERROR_MS, f'{work} lasted {error_ms} ms longer than configured'
+    check_baseline(target, {'phase_error_ms': error_ms})
+
+    send(dut, 'restart')
+
+
+# === Targets ===
+
+
+@pytest.mark.host_test
+@pytest.mark.qemu
+@idf_parametrize('target', ['esp32', 'esp32c3'], indirect=['target'])
+def test_command_load_qemu(dut: IdfDut, target: str) -> None:
+    run_command_load(dut, target)
+
+
+@pytest.mark.host_test
+@pytest.mark.qemu
+@idf_parametrize('target', ['esp32', 'esp32c3'], indirect=['target'])
+def test_phase_accuracy_qemu(dut: IdfDut, target: str) -> None:
+    run_phase_accuracy(dut, target)
+
+
+@pytest.mark.host_test
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_command_load_linux(dut: IdfDut, target: str) -> None:
+    run_command_load(dut, target)
+
+
+@pytest.mark.host_test
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_phase_accuracy_linux(dut: IdfDut, target: str) -> None:
+    run_phase_accuracy(dut, target)
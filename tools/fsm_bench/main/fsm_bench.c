@@ -0,0 +1,91 @@
+#include "esp_cpu.h"
+#include "pomodoro_fsm.h"
+#include <inttypes.h>
+#include <stdio.h>
+
+/*
+ * Compares the generic FSM with one specialized for the same schedule
+ * (pomodoro_fsm_fixed.h).
+ *
+ * Both run the same event sequence, which visits every transition that
+ * produces effects, and report CPU cycles per dispatch and the size of their
+ * session. Build with the firmware's sdkconfig to compare what ships.
+ */
+
+#define BENCH_DISPATCHES 100000
+
+#define POMODORO_FIXED_PREFIX bench
+#define POMODORO_FIXED_SCHEDULE(PHASE)                                         \
+  PHASE("Work", 25 * 60 * 1000, true)                                          \
+  PHASE("Rest", 5 * 60 * 1000, false)                                          \
+  PHASE("Work", 25 * 60 * 1000, true)                                          \
+  PHASE("Long rest", 15 * 60 * 1000, false)
+#include "pomodoro_fsm_fixed.h"
+
+static const pomodoro_event_t EVENTS[] = {
+    POMODORO_EVT_START,   POMODORO_EVT_PAUSE,   POMODORO_EVT_RESUME,
+    POMODORO_EVT_HALFWAY, POMODORO_EVT_SKIP,    POMODORO_EVT_PAUSE,
+    POMODORO_EVT_SKIP,    POMODORO_EVT_WARNING, POMODORO_EVT_TIMEOUT,
+    POMODORO_EVT_TIMEOUT, POMODORO_EVT_TIMEOUT, POMODORO_EVT_RESTART,
+};
+
+#define EVENT_COUNT (sizeof(EVENTS) / sizeof(EVENTS[0]))
+
+// Out of line, so that `nm` lists its size next to the generic
+// pomodoro_session_dispatch()
+__attribute__((noinline)) static pomodoro_err_t
+fixed_dispatch(bench_session_t *session, pomodoro_event_t event,
+               uint32_t now_ms, pomodoro_effects_t *effects) {
+  return bench_session_dispatch(session, event, now_ms, effects);
+}
+
+static void print_result(const char *name, uint32_t cycles, uint32_t effects,
+                         size_t session_size) {
+  printf("fsm=%s cycles_per_dispatch=%" PRIu32 " effects=%" PRIu32
+         " session_bytes=%u\n",
+         name, cycles / BENCH_DISPATCHES, effects, (unsigned)session_size);
+}
+
+static void run_generic(void) {
+  pomodoro_session_t session;
+  pomodoro_effects_t effects;
+  pomodoro_session_initialize(&session, &effects, &bench_config);
+
+  uint32_t effects_total = 0;
+  uint32_t started = esp_cpu_get_cycle_count();
+  for (uint32_t i = 0; i < BENCH_DISPATCHES; i++) {
+    pomodoro_session_dispatch(&session, EVENTS[i % EVENT_COUNT], i * 1000,
+                              &effects);
+    effects_total += effects.count;
+  }
+  uint32_t cycles = esp_cpu_get_cycle_count() - started;
+
+  print_result("generic", cycles, effects_total, sizeof(session));
+}
+
+static void run_fixed(void) {
+  bench_session_t session;
+  pomodoro_effects_t effects;
+  bench_session_initialize(&session, &effects);
+
+  uint32_t effects_total = 0;
+  uint32_t started = esp_cpu_get_cycle_count();
+  for (uint32_t i = 0; i < BENCH_DISPATCHES; i++) {
+    fixed_dispatch(&session, EVENTS[i % EVENT_COUNT], i * 1000, &effects);
+    effects_total += effects.count;
+  }
+  uint32_t cycles = esp_cpu_get_cycle_count() - started;
+
+  print_result("fixed", cycles, effects_total, sizeof(session));
+}
+
+void app_main(void) {
+  printf("fsm_bench dispatches=%d events=%u\n", BENCH_DISPATCHES,
+         (unsigned)EVENT_COUNT);
+
+  // Both get the same input, so `effects` must match
+  run_generic();
+  run_fixed();
+
+  printf("fsm_bench done\n");
+}
@@ -0,0 +1,126 @@
+"""Host tests for tools/telemetry_decode.py, no device needed:
+
+    pytest tools/pytest_telemetry_decode.py
+"""
+import os
+import sys
+from typing import List
+
+sys.path.insert(0, os.path.dirname(__file__))
+
+from telemetry_decode import (  # noqa: E402
+    FIELD_REMAINING,
+    FLAG_KEYFRAME,
+    STATE_RUNNING,
+    SYNC,
+    StreamDecoder,
+    crc8,
+    read_port,
+)
+
+
+class FakeSerial:
+    """Hands out `chunks` like pyserial would, then times out (empty read)."""
+
+    def __init__(self, chunks: List[bytes]) -> None:
+        self.chunks = list(chunks)
+        self.pending = b''
+        self.reads: List[int] = []
+
+    @property
+    def in_waiting(self) -> int:
+        if not self.pending and self.chunks:
+            self.pending = self.chunks.pop(0)
+        return len(self.pending)
+
+    def read(self, size: int = 1) -> bytes:
+        self.reads.append(size)
+        self.in_waiting
+        data, self.pending = self.pending[:size], self.pending[size:]
+        return data
+
+
+def varint(value: int) -> bytes:
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def frame(payload: bytes) -> bytes:
+    body = bytes([len(payload)]) + payload
+    return bytes([SYNC]) + body + bytes([crc8(body)])
+
+
+def keyframe(seq: int, interval_ms: int, timestamp_ms: int, remaining_ms: int,
+             transitions: int) -> bytes:
+    return frame(
+        bytes([FLAG_KEYFRAME, seq]) + varint(interval_ms) + varint(timestamp_ms)
+        + bytes([STATE_RUNNING]) + varint(0) + varint(remaining_ms)
+        + varint(transitions))
+
+
+def delta(seq: int) -> bytes:
+    # Everything as predicted, only the header
+    return frame(bytes([0, seq]))
+
+
+def test_port_is_read_in_chunks_until_timeout():
+    first = keyframe(0, 1000, 5000, 60000, 1)
+    log = b'I (42) log\n'
+    stream = first + log + delta(1) + delta(2)
+    # Frames cut across chunks, with a log line between two of them
+    chunks = [stream[:4], stream[4:len(first) + 6], stream[len(first) + 6:]]
+    port = FakeSerial(chunks)
+
+    decoder = StreamDecoder()
+    records = []
+    for chunk in read_port(port):
+        records += decoder.feed(chunk)
+
+    assert [r.seq for r in records] == [0, 1, 2]
+    assert [r.timestamp_ms for r in records] == [5000, 6000, 7000]
+    assert [r.remaining_ms for r in records] == [60000, 59000, 58000]
+    assert decoder.decoder.lost_frames == 0
+    assert decoder.bytes_read == len(stream)
+    # One read per chunk, then a single byte read that times out
+    assert port.reads == [len(c) for c in chunks] + [1]
+
+
+def test_rate_change_keyframe_keeps_the_sequence():
+    stream = (
+        keyframe(7, 1000, 5000, 60000, 3) + delta(8)
+        # `telemetry 10hz`: new interval, same counter
+        + keyframe(9, 100, 6100, 58900, 3) + delta(10)
+        + frame(bytes([1 << FIELD_REMAINING, 11]) + varint(2 * 5)))
+
+    decoder = StreamDecoder()
+    records = decoder.feed(stream)
+
+    assert [r.seq for r in records] == [7, 8, 9, 10, 11]
+    assert [r.timestamp_ms for r in records] == [5000, 6000, 6100, 6200, 6300]
+    assert records[-1].remaining_ms == 58700 + 5
+    assert decoder.decoder.interval_ms == 100
+    assert decoder.decoder.lost_frames == 0
+
+
+def test_gap_in_sequence_counts_lost_frames():
+    decoder = StreamDecoder()
+    decoder.feed(keyframe(0, 1000, 0, 60000, 0) + delta(1) + delta(4))
+    assert decoder.decoder.lost_frames == 2
+
+
+def test_frame_with_newline_bytes_round_trips():
+    # Interval 10 ms and a remaining time of 0x0A0A: 0x0A in the payload
+    stream = keyframe(0x0A, 10, 1000, 0x0A0A, 0) + delta(0x0B)
+    assert stream.count(b'\n') >= 3
+
+    records = StreamDecoder().feed(stream)
+    assert [r.seq for r in records] == [0x0A, 0x0B]
+    assert records[0].remaining_ms == 0x0A0A
+
+    # What a console converting LF to CRLF would have sent instead
+    translated = stream.replace(b'\n', b'\r\n')
+    assert [r.seq for r in StreamDecoder().feed(translated)] != [0x0A, 0x0B]
@@ -0,0 +1,250 @@
+#include "pomodoro_fsm.h"
+#include "pomodoro_reactor_types.h"
+#include "pomodoro_recorder.h"
+#include "pomodoro_replay.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Reads a mode line from stdin:
+ *
+ *   replay
+ *     Followed by a serial capture that contains a recorder dump. Every
+ *     recorded event is dispatched again and compared with its recorded
+ *     result.
+ *
+ *   simulate <days> [seed]
+ *     Optionally followed by `phase <name> <duration_ms> [focus]` lines
+ *     (`focus` is 0 or 1, default 0). Drives a synthetic user against the
+ *     schedule under the virtual clock.
+ */
+
+#define MS_PER_SECOND 1000u
+#define MS_PER_MINUTE (60u * MS_PER_SECOND)
+#define MS_PER_DAY (24ull * 60u * MS_PER_MINUTE)
+
+static double wall_clock_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void print_stats(const pomodoro_replay_t *replay, double wall_s) {
+  const pomodoro_replay_stats_t *stats = &replay->stats;
+  double virtual_s = (double)replay->elapsed_ms / MS_PER_SECOND;
+
+  printf("virtual_time_s=%.0f wall_time_s=%.3f speedup=%.0fx\n", virtual_s,
+         wall_s, wall_s > 0 ? virtual_s / wall_s : 0);
+  printf("events=%" PRIu64 " ui_events=%" PRIu64 " ok=%" PRIu64
+         " failed=%" PRIu64 " timeouts_simulated=%" PRIu64 "\n",
+         stats->events, stats->ui_events, stats->dispatch_ok,
+         stats->dispatch_failed, stats->timeouts_simulated);
+  printf("phases_completed=%" PRIu64 " sessions_finished=%" PRIu64
+         " mismatches=%" PRIu64 " max_timeout_drift_ms=%" PRIu32 "\n",
+         stats->phases_completed, stats->sessions_finished, stats->mismatches,
+         stats->max_timeout_drift_ms);
+  printf("final state=\"%s\" phase_index=%" PRIu32 " events_per_s=%.0f\n",
+         pomodoro_state_to_string(replay->session.state),
+         replay->session.phase_index,
+         wall_s > 0 ? (double)stats->events / wall_s : 0);
+}
+
+// === Replay of a recording ===
+
+static void report_mismatch(void *ctx, const pomodoro_replay_t *replay,
+                            const pomodoro_record_t *expected,
+                            pomodoro_err_t actual) {
+  (void)ctx;
+  printf("MISMATCH at t=%" PRIu32 " event=%d: recorded %s, replayed %s "
+         "(state=\"%s\" phase_index=%" PRIu32 ")\n",
+         expected->event.timestamp_ms, (int)expected->event.data.fsm_event,
+         pomodoro_err_to_string(expected->result),
+         pomodoro_err_to_string(actual),
+         pomodoro_state_to_string(replay->session.state),
+         replay->session.phase_index);
+}
+
+static int run_replay(void) {
+  static pomodoro_recording_t recording;
+
+  if (pomodoro_recording_load(&recording, stdin) != POMODORO_STATUS_OK) {
+    fprintf(stderr, "No complete recording found on stdin\n");
+    return 1;
+  }
+
+  printf("Loaded %" PRIu32 " records (%" PRIu32 " evicted on device)\n",
+         recording.count, recording.evicted);
+
+  uint32_t start_ms =
+      recording.count > 0 ? recording.records[0].event.timestamp_ms : 0;
+
+  pomodoro_replay_cursor_t cursor = {.recording = &recording};
+  pomodoro_replay_t replay;
+  pomodoro_replay_initialize(&replay, &recording.base, start_ms,
+                             POMODORO_REPLAY_TIMEOUTS_RECORDED,
+                             pomodoro_replay_recording_source, &cursor);
+  replay.on_mismatch = report_mismatch;
+
+  double started = wall_clock_seconds();
+  pomodoro_replay_run(&replay, UINT64_MAX);
+  print_stats(&replay, wall_clock_seconds() - started);
+
+  return replay.stats.mismatches == 0 ? 0 : 2;
+}
+
+// === Synthetic load ===
+
+typedef struct synthetic_user {
+  uint32_t rng;
+} synthetic_user_t;
+
+// xorshift32: deterministic for a given seed, which keeps runs reproducible
+static uint32_t next_random(synthetic_user_t *user) {
+  uint32_t x = user->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  user->rng = x;
+  return x;
+}
+
+static uint32_t random_below(synthetic_user_t *user, uint32_t bound) {
+  return bound == 0 ? 0 : next_random(user) % bound;
+}
+
+static bool synthetic_source(void *ctx, const pomodoro_replay_t *replay,
+                             pomodoro_record_t *out) {
+  synthetic_user_t *user = (synthetic_user_t *)ctx;
+  const pomodoro_session_t *session = &replay->session;
+
+  pomodoro_event_t event;
+  uint32_t delay_ms;
+
+  switch (session->state) {
+  case POMODORO_STATE_IDLE:
+    event = POMODORO_EVT_START;
+    delay_ms = random_below(user, 2 * MS_PER_MINUTE);
+    break;
+  case POMODORO_STATE_RUNNING: {
+    // Interruptions land anywhere in the phase, or after it if the timer wins
+    uint32_t phase_ms = pomodoro_current_phase(session)->duration_ms;
+    event = random_below(user, 8) == 0 ? POMODORO_EVT_SKIP : POMODORO_EVT_PAUSE;
+    delay_ms = random_below(user, 3 * phase_ms);
+  } break;
+  case POMODORO_STATE_PAUSED:
+    event = POMODORO_EVT_RESUME;
+    delay_ms = random_below(user, 5 * MS_PER_MINUTE);
+    break;
+  case POMODORO_STATE_FINISHED:
+  default:
+    event = POMODORO_EVT_RESTART;
+    delay_ms = random_below(user, 10 * MS_PER_MINUTE);
+    break;
+  }
+
+  *out = (pomodoro_record_t){
+      .event =
+          {
+              .type = REACTOR_FSM_EVENT,
+              .timestamp_ms = replay->now_ms + delay_ms,
+              .data.fsm_event = event,
+          },
+      // No expectation: synthetic input is not compared
+      .result = POMODORO_STATUS_COUNT,
+  };
+  return true;
+}
+
+static const pomodoro_config_t default_schedule = {
+    .phases =
+        {
+            {.name = "Work",
+             .duration_ms = 25 * MS_PER_MINUTE,
+             .focus = true},
+            {.name = "Rest", .duration_ms = 5 * MS_PER_MINUTE},
+            {.name = "Work",
+             .duration_ms = 25 * MS_PER_MINUTE,
+             .focus = true},
+            {.name = "Rest", .duration_ms = 5 * MS_PER_MINUTE},
+            {.name = "Work",
+             .duration_ms = 25 * MS_PER_MINUTE,
+             .focus = true},
+            {.name = "Rest", .duration_ms = 5 * MS_PER_MINUTE},
+            {.name = "Work",
+             .duration_ms = 25 * MS_PER_MINUTE,
+             .focus = true},
+            {.name = "LongRest", .duration_ms = 15 * MS_PER_MINUTE},
+        },
+    .count = 8,
+};
+
+static int run_simulation(const char *mode_line) {
+  static pomodoro_config_t config;
+
+  uint32_t days = 0;
+  uint32_t seed = 1;
+  if (sscanf(mode_line, "simulate %" SCNu32 " %" SCNu32, &days, &seed) < 1 ||
+      days == 0) {
+    fprintf(stderr, "Usage: simulate <days> [seed]\n");
+    return 1;
+  }
+
+  char line[128];
+  char name[MAX_NAME];
+  uint32_t duration_ms;
+  config.count = 0;
+  while (fgets(line, sizeof(line), stdin) != NULL &&
+         config.count < MAX_PHASES) {
+    int focus = 0;
+    if (sscanf(line, "phase %24s %" SCNu32 " %d", name, &duration_ms,
+               &focus) >= 2) {
+      snprintf(config.phases[config.count].name, MAX_NAME, "%s", name);
+      config.phases[config.count].duration_ms = duration_ms;
+      config.phases[config.count].focus = focus != 0;
+      config.count++;
+    }
+  }
+  if (config.count == 0) {
+    config = default_schedule;
+  }
+
+  pomodoro_session_t session;
+  pomodoro_effects_t effects;
+  pomodoro_session_initialize(&session, &effects, &config);
+
+  synthetic_user_t user = {.rng = seed != 0 ? seed : 1};
+  pomodoro_replay_t replay;
+  pomodoro_replay_initialize(&replay, &session, 0,
+                             POMODORO_REPLAY_TIMEOUTS_SIMULATED,
+                             synthetic_source, &user);
+
+  printf("Simulating %" PRIu32 " days, %" PRIu32 " phases, seed=%" PRIu32 "\n",
+         days, config.count, seed);
+
+  double started = wall_clock_seconds();
+  pomodoro_replay_run(&replay, (uint64_t)days * MS_PER_DAY);
+  print_stats(&replay, wall_clock_seconds() - started);
+
+  return 0;
+}
+
+void app_main(void) {
+  char mode_line[128];
+  int status = 1;
+
+  if (fgets(mode_line, sizeof(mode_line), stdin) == NULL) {
+    fprintf(stderr, "Expected `replay` or `simulate <days> [seed]`\n");
+  } else if (strncmp(mode_line, "replay", 6) == 0) {
+    status = run_replay();
+  } else if (strncmp(mode_line, "simulate", 8) == 0) {
+    status = run_simulation(mode_line);
+  } else {
+    fprintf(stderr, "Unknown mode: %s", mode_line);
+  }
+
+  fflush(stdout);
+  exit(status);
+}
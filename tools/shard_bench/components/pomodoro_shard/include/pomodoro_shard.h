@@ -0,0 +1,132 @@
+#ifndef POMODORO_SHARD_H
+#define POMODORO_SHARD_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "pomodoro_effect_bus.h"
+#include "pomodoro_fsm.h"
+#include "pomodoro_reactor_types.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define POMODORO_MAX_SHARDS 2
+#define POMODORO_SHARD_MAX_SESSIONS 64
+#define POMODORO_SHARD_QUEUE_LENGTH 32
+#define POMODORO_SHARD_TASK_STACK 3072
+
+#define POMODORO_SHARD_MAX_DEADLINES                                           \
+  (POMODORO_SHARD_MAX_SESSIONS * POMODORO_TIMER_COUNT)
+
+typedef struct pomodoro_shard_deadline {
+  uint32_t deadline_ms;
+  uint8_t slot; // Session slot inside the shard
+  uint8_t timer_id;
+} pomodoro_shard_deadline_t;
+
+/*
+ * @brief Timer service of one shard, keyed by (session slot, timer id).
+ *
+ * A binary min-heap of every pending deadline of the shard's sessions.
+ * `position` maps each key to its heap index (plus one, 0 when not armed), so
+ * arming, re-arming and stopping a single timer are all O(log n). The shard
+ * task sleeps on its queue until `heap[0]` is due, so there is no hardware
+ * timer, callback or lock involved.
+ */
+typedef struct pomodoro_shard_timers {
+  pomodoro_shard_deadline_t heap[POMODORO_SHARD_MAX_DEADLINES];
+  uint16_t position[POMODORO_SHARD_MAX_SESSIONS][POMODORO_TIMER_COUNT];
+  uint32_t count;
+} pomodoro_shard_timers_t;
+
+// Queue item of a shard: events for one session
+typedef struct pomodoro_shard_item {
+  uint16_t session_id;
+  reactor_batch_t batch;
+} pomodoro_shard_item_t;
+
+// Written by the shard task only; other tasks may read them for monitoring
+typedef struct pomodoro_shard_stats {
+  uint32_t events; // FSM and UI events, after unpacking batches
+  uint32_t dispatch_ok;
+  uint32_t dispatch_failed;
+  uint32_t timer_events; // Dispatched by the timer service
+} pomodoro_shard_stats_t;
+
+/*
+ * @brief One reactor: a queue, a task and the sessions it owns.
+ *
+ * Session `id` lives on shard `id % shard_count`, in slot `id / shard_count`.
+ * Everything but the queue is only touched by the shard's own task, so shards
+ * never share state and run without locks.
+ */
+typedef struct pomodoro_shard {
+  uint32_t index;
+  uint32_t shard_count;
+  uint32_t session_count;
+  char name[12];
+  QueueHandle_t queue;
+
+  pomodoro_session_t sessions[POMODORO_SHARD_MAX_SESSIONS];
+  pomodoro_effects_t effects;
+  pomodoro_shard_timers_t timers;
+
+  // Handlers may read `current_session_id` to know whose effects they get.
+  // Register them before the runtime starts.
+  pomodoro_effect_bus_t bus;
+  uint16_t current_session_id;
+
+  pomodoro_shard_stats_t stats;
+} pomodoro_shard_t;
+
+typedef struct pomodoro_shard_runtime {
+  pomodoro_shard_t shards[POMODORO_MAX_SHARDS];
+  uint32_t shard_count;
+  uint32_t session_count;
+  atomic_uint_fast32_t dropped; // Shard queue full at send time
+} pomodoro_shard_runtime_t;
+
+/*
+ * @brief Creates `shard_count` shards sharing `session_count` sessions, all
+ * using `config`. Does not start the tasks.
+ *
+ * @return POMODORO_STATUS_INVALID_ARGUMENTS if `shard_count` is 0 or above
+ * POMODORO_MAX_SHARDS, or the sessions do not fit in the shards.
+ */
+pomodoro_err_t
+pomodoro_shard_runtime_initialize(pomodoro_shard_runtime_t *runtime,
+                                  const pomodoro_config_t *config,
+                                  uint32_t shard_count,
+                                  uint32_t session_count);
+
+/*
+ * @brief Starts one reactor task per shard, shard `i` pinned to core
+ * `i % portNUM_PROCESSORS`.
+ */
+void pomodoro_shard_runtime_start(pomodoro_shard_runtime_t *runtime,
+                                  UBaseType_t priority);
+
+static inline uint32_t
+pomodoro_shard_of(const pomodoro_shard_runtime_t *runtime,
+                  uint16_t session_id) {
+  return session_id % runtime->shard_count;
+}
+
+/*
+ * @brief Routes `batch` to the shard owning `session_id`, which dispatches it
+ * back-to-back. Safe to call from any task.
+ *
+ * @return false if the session does not exist, or if the shard's queue stayed
+ * full for `ticks_to_wait` (counted in `dropped`).
+ */
+bool pomodoro_shard_runtime_send(pomodoro_shard_runtime_t *runtime,
+                                 uint16_t session_id,
+                                 const reactor_batch_t *batch,
+                                 TickType_t ticks_to_wait);
+
+/*
+ * @brief Reactor loop of one shard, `args` is a `pomodoro_shard_t`
+ */
+void pomodoro_shard_task(void *args);
+
+#endif // POMODORO_SHARD_H
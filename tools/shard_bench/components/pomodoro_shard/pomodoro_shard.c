@@ -0,0 +1,288 @@
+#include "pomodoro_shard.h"
+#include "freertos/task.h"
+#include <assert.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t now_ms(void) { return pdTICKS_TO_MS(xTaskGetTickCount()); }
+
+// === Timer service ===
+
+static bool earlier(const pomodoro_shard_deadline_t *a,
+                    const pomodoro_shard_deadline_t *b) {
+  // Deadlines wrap with `now_ms`
+  return (int32_t)(a->deadline_ms - b->deadline_ms) < 0;
+}
+
+static void heap_place(pomodoro_shard_timers_t *timers, uint32_t index,
+                       pomodoro_shard_deadline_t deadline) {
+  timers->heap[index] = deadline;
+  timers->position[deadline.slot][deadline.timer_id] = (uint16_t)(index + 1);
+}
+
+static void sift_up(pomodoro_shard_timers_t *timers, uint32_t index) {
+  pomodoro_shard_deadline_t deadline = timers->heap[index];
+  while (index > 0) {
+    uint32_t parent = (index - 1) / 2;
+    if (!earlier(&deadline, &timers->heap[parent])) {
+      break;
+    }
+    heap_place(timers, index, timers->heap[parent]);
+    index = parent;
+  }
+  heap_place(timers, index, deadline);
+}
+
+static void sift_down(pomodoro_shard_timers_t *timers, uint32_t index) {
+  pomodoro_shard_deadline_t deadline = timers->heap[index];
+  while (true) {
+    uint32_t child = 2 * index + 1;
+    if (child >= timers->count) {
+      break;
+    }
+    if (child + 1 < timers->count &&
+        earlier(&timers->heap[child + 1], &timers->heap[child])) {
+      child++;
+    }
+    if (!earlier(&timers->heap[child], &deadline)) {
+      break;
+    }
+    heap_place(timers, index, timers->heap[child]);
+    index = child;
+  }
+  heap_place(timers, index, deadline);
+}
+
+// Restores the heap after the entry at `index` changed
+static void sift(pomodoro_shard_timers_t *timers, uint32_t index) {
+  if (index > 0 &&
+      earlier(&timers->heap[index], &timers->heap[(index - 1) / 2])) {
+    sift_up(timers, index);
+  } else {
+    sift_down(timers, index);
+  }
+}
+
+static void timers_arm(pomodoro_shard_timers_t *timers, uint8_t slot,
+                       pomodoro_timer_id_t timer_id, uint32_t deadline_ms) {
+  uint16_t position = timers->position[slot][timer_id];
+  if (position != 0) {
+    // Re-arming replaces the previous deadline
+    timers->heap[position - 1].deadline_ms = deadline_ms;
+    sift(timers, position - 1);
+    return;
+  }
+
+  assert(timers->count < POMODORO_SHARD_MAX_DEADLINES);
+  uint32_t index = timers->count++;
+  heap_place(timers, index,
+             (pomodoro_shard_deadline_t){
+                 .deadline_ms = deadline_ms,
+                 .slot = slot,
+                 .timer_id = (uint8_t)timer_id,
+             });
+  sift_up(timers, index);
+}
+
+static void timers_stop(pomodoro_shard_timers_t *timers, uint8_t slot,
+                        pomodoro_timer_id_t timer_id) {
+  uint16_t position = timers->position[slot][timer_id];
+  if (position == 0) {
+    return;
+  }
+
+  timers->position[slot][timer_id] = 0;
+  uint32_t index = position - 1;
+  timers->count--;
+  if (index == timers->count) {
+    return;
+  }
+
+  // Fill the hole with the last entry
+  heap_place(timers, index, timers->heap[timers->count]);
+  sift(timers, index);
+}
+
+static void timers_handle_effects(pomodoro_shard_timers_t *timers,
+                                  uint8_t slot,
+                                  const pomodoro_effects_t *effects,
+                                  uint32_t now_ms) {
+  for (uint32_t i = 0; i < effects->count; i++) {
+    const pomodoro_effect_t *effect = &effects->effects[i];
+
+    switch (effect->type) {
+    case POMODORO_EFFECT_TIMER_START:
+      timers_arm(timers, slot, effect->timer_start.timer_id,
+                 now_ms + effect->timer_start.timeout_ms);
+      break;
+    case POMODORO_EFFECT_TIMER_STOP:
+      if (effect->timer_stop.timer_id == POMODORO_TIMER_ALL) {
+        for (uint32_t id = 0; id < POMODORO_TIMER_COUNT; id++) {
+          timers_stop(timers, slot, (pomodoro_timer_id_t)id);
+        }
+      } else {
+        timers_stop(timers, slot, effect->timer_stop.timer_id);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+// === Shards ===
+
+static void shard_dispatch(pomodoro_shard_t *shard, uint16_t session_id,
+                           pomodoro_event_t event, uint32_t timestamp_ms) {
+  uint8_t slot = (uint8_t)(session_id / shard->shard_count);
+
+  pomodoro_err_t status = pomodoro_session_dispatch(
+      &shard->sessions[slot], event, timestamp_ms, &shard->effects);
+
+  if (status != POMODORO_STATUS_OK) {
+    shard->stats.dispatch_failed++;
+    return;
+  }
+  shard->stats.dispatch_ok++;
+
+  timers_handle_effects(&shard->timers, slot, &shard->effects, timestamp_ms);
+
+  shard->current_session_id = session_id;
+  pomodoro_effect_bus_dispatch(&shard->bus, &shard->effects);
+}
+
+static void shard_fire_timers(pomodoro_shard_t *shard) {
+  pomodoro_shard_timers_t *timers = &shard->timers;
+  uint32_t now = now_ms();
+
+  while (timers->count > 0 &&
+         (int32_t)(timers->heap[0].deadline_ms - now) <= 0) {
+    pomodoro_shard_deadline_t due = timers->heap[0];
+    timers_stop(timers, due.slot, (pomodoro_timer_id_t)due.timer_id);
+
+    uint16_t session_id =
+        (uint16_t)(due.slot * shard->shard_count + shard->index);
+    shard->stats.events++;
+    shard->stats.timer_events++;
+    shard_dispatch(shard, session_id,
+                   pomodoro_timer_event((pomodoro_timer_id_t)due.timer_id),
+                   now);
+  }
+}
+
+// Ticks until the earliest deadline, rounded up so that the task never wakes
+// before it is due
+static TickType_t shard_wait_ticks(const pomodoro_shard_t *shard) {
+  if (shard->timers.count == 0) {
+    return portMAX_DELAY;
+  }
+
+  int32_t until_ms = (int32_t)(shard->timers.heap[0].deadline_ms - now_ms());
+  if (until_ms <= 0) {
+    return 0;
+  }
+  return ((TickType_t)until_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+}
+
+void pomodoro_shard_task(void *args) {
+  pomodoro_shard_t *shard = (pomodoro_shard_t *)args;
+
+  while (true) {
+    pomodoro_shard_item_t received;
+    if (xQueueReceive(shard->queue, &received, shard_wait_ticks(shard))) {
+      timestamped_event_t unpacked_events[MAX_BATCH_EVENTS];
+      uint32_t unpacked_count =
+          reactor_batch_unpack(&received.batch, unpacked_events);
+
+      for (uint32_t i = 0; i < unpacked_count; i++) {
+        const timestamped_event_t *event = &unpacked_events[i];
+        shard->stats.events++;
+
+        // UI events have no meaning per session
+        if (event->type == REACTOR_FSM_EVENT) {
+          shard_dispatch(shard, received.session_id, event->data.fsm_event,
+                         event->timestamp_ms);
+        }
+      }
+    }
+
+    shard_fire_timers(shard);
+  }
+}
+
+// === Runtime ===
+
+pomodoro_err_t
+pomodoro_shard_runtime_initialize(pomodoro_shard_runtime_t *runtime,
+                                  const pomodoro_config_t *config,
+                                  uint32_t shard_count,
+                                  uint32_t session_count) {
+  // Sanity checks
+  assert(runtime != NULL);
+  assert(config != NULL);
+
+  if (shard_count == 0 || shard_count > POMODORO_MAX_SHARDS ||
+      session_count > shard_count * POMODORO_SHARD_MAX_SESSIONS) {
+    return POMODORO_STATUS_INVALID_ARGUMENTS;
+  }
+
+  memset(runtime, 0, sizeof(*runtime));
+  runtime->shard_count = shard_count;
+  runtime->session_count = session_count;
+  atomic_init(&runtime->dropped, 0);
+
+  for (uint32_t i = 0; i < shard_count; i++) {
+    pomodoro_shard_t *shard = &runtime->shards[i];
+    shard->index = i;
+    shard->shard_count = shard_count;
+    // Sessions i, i + shard_count, i + 2 * shard_count...
+    shard->session_count = (session_count + shard_count - 1 - i) / shard_count;
+    snprintf(shard->name, sizeof(shard->name), "shard-%" PRIu32, i);
+
+    shard->queue = xQueueCreate(POMODORO_SHARD_QUEUE_LENGTH,
+                                sizeof(pomodoro_shard_item_t));
+    configASSERT(shard->queue);
+
+    for (uint32_t slot = 0; slot < shard->session_count; slot++) {
+      pomodoro_session_initialize(&shard->sessions[slot], &shard->effects,
+                                  config);
+    }
+    pomodoro_effect_bus_initialize(&shard->bus);
+  }
+
+  return POMODORO_STATUS_OK;
+}
+
+void pomodoro_shard_runtime_start(pomodoro_shard_runtime_t *runtime,
+                                  UBaseType_t priority) {
+  for (uint32_t i = 0; i < runtime->shard_count; i++) {
+    pomodoro_shard_t *shard = &runtime->shards[i];
+    BaseType_t created = xTaskCreatePinnedToCore(
+        pomodoro_shard_task, shard->name, POMODORO_SHARD_TASK_STACK, shard,
+        priority, NULL, (BaseType_t)(i % portNUM_PROCESSORS));
+    configASSERT(created == pdPASS);
+  }
+}
+
+bool pomodoro_shard_runtime_send(pomodoro_shard_runtime_t *runtime,
+                                 uint16_t session_id,
+                                 const reactor_batch_t *batch,
+                                 TickType_t ticks_to_wait) {
+  if (session_id >= runtime->session_count) {
+    return false;
+  }
+
+  pomodoro_shard_item_t item = {
+      .session_id = session_id,
+      .batch = *batch,
+  };
+  pomodoro_shard_t *shard =
+      &runtime->shards[pomodoro_shard_of(runtime, session_id)];
+  if (xQueueSend(shard->queue, &item, ticks_to_wait) != pdTRUE) {
+    atomic_fetch_add(&runtime->dropped, 1);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,213 @@
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "pomodoro_effect_bus.h"
+#include "pomodoro_fsm.h"
+#include "pomodoro_reactor_types.h"
+#include "pomodoro_shard.h"
+#include <inttypes.h>
+#include <stdio.h>
+
+/*
+ * Compares one reactor shard with two under the same synthetic load.
+ *
+ * BENCH_SESSIONS sessions receive random user input from one producer task
+ * per core. Every send is a batch of MAX_BATCH_EVENTS events for one session,
+ * and producers block while a shard's queue is full, so a run measures how
+ * fast the shards drain their queues rather than how many events get dropped.
+ * Phases are short enough for the shards' timer services to fire during the
+ * run. Both runs use the same seeds and therefore the same input.
+ */
+
+#define BENCH_SESSIONS 64
+#define BENCH_BATCHES_PER_PRODUCER 20000
+#define BENCH_PRODUCERS portNUM_PROCESSORS
+#define BENCH_PRIORITY (tskIDLE_PRIORITY + 2)
+#define BENCH_STACK 3072
+
+static const pomodoro_config_t BENCH_CONFIG = {
+    .phases =
+        {
+            {.name = "Work", .duration_ms = 200, .focus = true},
+            {.name = "Rest", .duration_ms = 100},
+            {.name = "Work", .duration_ms = 200, .focus = true},
+            {.name = "Long rest", .duration_ms = 300},
+        },
+    .count = 4,
+};
+
+// Mostly valid input, with the occasional restart
+static const pomodoro_event_t USER_EVENTS[] = {
+    POMODORO_EVT_START,  POMODORO_EVT_PAUSE, POMODORO_EVT_RESUME,
+    POMODORO_EVT_SKIP,   POMODORO_EVT_PAUSE, POMODORO_EVT_RESUME,
+    POMODORO_EVT_START,  POMODORO_EVT_RESTART,
+};
+
+#define USER_EVENT_COUNT (sizeof(USER_EVENTS) / sizeof(USER_EVENTS[0]))
+
+typedef struct bench_producer {
+  pomodoro_shard_runtime_t *runtime;
+  uint32_t seed;
+  uint32_t events_sent;
+  SemaphoreHandle_t done;
+} bench_producer_t;
+
+static uint32_t xorshift32(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+static void producer_task(void *args) {
+  bench_producer_t *producer = (bench_producer_t *)args;
+
+  for (uint32_t i = 0; i < BENCH_BATCHES_PER_PRODUCER; i++) {
+    uint16_t session_id =
+        (uint16_t)(xorshift32(&producer->seed) % BENCH_SESSIONS);
+    reactor_batch_t batch;
+    reactor_batch_initialize(&batch, pdTICKS_TO_MS(xTaskGetTickCount()));
+
+    for (uint32_t j = 0; j < MAX_BATCH_EVENTS; j++) {
+      timestamped_event_t event = {
+          .type = REACTOR_FSM_EVENT,
+          .data.fsm_event =
+              USER_EVENTS[xorshift32(&producer->seed) % USER_EVENT_COUNT],
+      };
+      reactor_batch_append(&batch, &event);
+    }
+
+    if (pomodoro_shard_runtime_send(producer->runtime, session_id, &batch,
+                                    portMAX_DELAY)) {
+      producer->events_sent += batch.count;
+    }
+  }
+
+  xSemaphoreGive(producer->done);
+  vTaskDelete(NULL);
+}
+
+// Stands in for the effect handlers of a real application
+static void count_effect(void *ctx, const pomodoro_effect_t *effect) {
+  (void)effect;
+  (*(uint32_t *)ctx)++;
+}
+
+// Events that came through the queues, i.e. not from the timer services
+static uint32_t
+input_events_processed(const pomodoro_shard_runtime_t *runtime) {
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < runtime->shard_count; i++) {
+    const pomodoro_shard_stats_t *stats = &runtime->shards[i].stats;
+    total += stats->events - stats->timer_events;
+  }
+  return total;
+}
+
+static void wait_until_processed(const pomodoro_shard_runtime_t *runtime,
+                                 uint32_t events) {
+  while (input_events_processed(runtime) < events) {
+    vTaskDelay(1);
+  }
+}
+
+static void run(uint32_t shard_count) {
+  static pomodoro_shard_runtime_t runtimes[POMODORO_MAX_SHARDS];
+  static uint32_t effects_handled[POMODORO_MAX_SHARDS][POMODORO_MAX_SHARDS];
+  static bench_producer_t producers[BENCH_PRODUCERS];
+
+  pomodoro_shard_runtime_t *runtime = &runtimes[shard_count - 1];
+  pomodoro_err_t status = pomodoro_shard_runtime_initialize(
+      runtime, &BENCH_CONFIG, shard_count, BENCH_SESSIONS);
+  configASSERT(status == POMODORO_STATUS_OK);
+
+  for (uint32_t i = 0; i < shard_count; i++) {
+    status = pomodoro_effect_bus_register(
+        &runtime->shards[i].bus, POMODORO_EFFECT_MASK_ALL, count_effect,
+        &effects_handled[shard_count - 1][i]);
+    configASSERT(status == POMODORO_STATUS_OK);
+  }
+
+  pomodoro_shard_runtime_start(runtime, BENCH_PRIORITY);
+
+  SemaphoreHandle_t done = xSemaphoreCreateCounting(BENCH_PRODUCERS, 0);
+  configASSERT(done);
+
+  int64_t started_us = esp_timer_get_time();
+
+  for (uint32_t p = 0; p < BENCH_PRODUCERS; p++) {
+    producers[p] = (bench_producer_t){
+        .runtime = runtime,
+        .seed = p + 1,
+        .done = done,
+    };
+    BaseType_t created =
+        xTaskCreatePinnedToCore(producer_task, "producer", BENCH_STACK,
+                                &producers[p], BENCH_PRIORITY, NULL, p);
+    configASSERT(created == pdPASS);
+  }
+
+  uint32_t events_sent = 0;
+  for (uint32_t p = 0; p < BENCH_PRODUCERS; p++) {
+    xSemaphoreTake(done, portMAX_DELAY);
+  }
+  for (uint32_t p = 0; p < BENCH_PRODUCERS; p++) {
+    events_sent += producers[p].events_sent;
+  }
+  wait_until_processed(runtime, events_sent);
+
+  int64_t elapsed_us = esp_timer_get_time() - started_us;
+
+  uint32_t timer_events = 0;
+  uint32_t dispatch_ok = 0;
+  uint32_t dispatch_failed = 0;
+  for (uint32_t i = 0; i < shard_count; i++) {
+    const pomodoro_shard_stats_t *stats = &runtime->shards[i].stats;
+    timer_events += stats->timer_events;
+    dispatch_ok += stats->dispatch_ok;
+    dispatch_failed += stats->dispatch_failed;
+  }
+
+  printf("shards=%" PRIu32 " sessions=%d events=%" PRIu32
+         " elapsed_us=%" PRId64 " events_per_s=%.0f\n",
+         shard_count, BENCH_SESSIONS, events_sent, elapsed_us,
+         elapsed_us > 0 ? (double)events_sent * 1e6 / (double)elapsed_us : 0);
+  printf("shards=%" PRIu32 " timer_events=%" PRIu32 " ok=%" PRIu32
+         " failed=%" PRIu32 " dropped=%" PRIu32 "\n",
+         shard_count, timer_events, dispatch_ok, dispatch_failed,
+         (uint32_t)atomic_load(&runtime->dropped));
+  for (uint32_t i = 0; i < shard_count; i++) {
+    printf("shard=%" PRIu32 " events=%" PRIu32 " effects=%" PRIu32 "\n", i,
+           runtime->shards[i].stats.events,
+           effects_handled[shard_count - 1][i]);
+  }
+
+  // Stop every timer, so that this runtime stays idle during the next run
+  for (uint16_t session_id = 0; session_id < BENCH_SESSIONS; session_id++) {
+    const timestamped_event_t restart = {
+        .type = REACTOR_FSM_EVENT,
+        .data.fsm_event = POMODORO_EVT_RESTART,
+    };
+    reactor_batch_t batch;
+    reactor_batch_initialize(&batch, pdTICKS_TO_MS(xTaskGetTickCount()));
+    reactor_batch_append(&batch, &restart);
+    pomodoro_shard_runtime_send(runtime, session_id, &batch, portMAX_DELAY);
+  }
+  wait_until_processed(runtime, events_sent + BENCH_SESSIONS);
+
+  vSemaphoreDelete(done);
+}
+
+void app_main(void) {
+  printf("shard_bench cores=%d batches_per_producer=%d producers=%d\n",
+         portNUM_PROCESSORS, BENCH_BATCHES_PER_PRODUCER, BENCH_PRODUCERS);
+
+  for (uint32_t shard_count = 1; shard_count <= POMODORO_MAX_SHARDS;
+       shard_count++) {
+    run(shard_count);
+  }
+
+  printf("shard_bench done\n");
+}
@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+"""Decoder for the binary telemetry stream (see pomodoro_telemetry.h).
+
+Reads a raw capture (or a serial port, with pyserial installed) and prints one
+`key=value` line per record, in the same shape as the text output:
+
+    python tools/telemetry_decode.py capture.bin
+    python tools/telemetry_decode.py --port /dev/ttyUSB0 --baud 115200
+
+Log lines interleaved with the binary stream are skipped: the decoder hunts for
+the sync byte and only accepts frames whose CRC matches. Delta frames received
+before the first keyframe cannot be reconstructed and are dropped.
+"""
+import argparse
+import sys
+from dataclasses import dataclass
+from typing import Any, BinaryIO, Iterator, List, Optional, Tuple
+
+SYNC = 0xA5
+FLAG_KEYFRAME = 0x80
+FIELD_TIMESTAMP = 0
+FIELD_STATE = 1
+FIELD_PHASE_INDEX = 2
+FIELD_REMAINING = 3
+FIELD_TRANSITIONS = 4
+STATE_RUNNING = 1
+STATE_NAMES = ['IDLE', 'RUNNING', 'PAUSED', 'FINISHED']
+
+
+@dataclass
+class Record:
+    seq: int
+    keyframe: bool
+    timestamp_ms: int
+    state: int
+    phase_index: int
+    remaining_ms: int
+    transitions: int
+
+    def to_line(self) -> str:
+        state = STATE_NAMES[self.state] if self.state < len(STATE_NAMES) else 'UNKNOWN'
+        return (
+            f'now_ms={self.timestamp_ms} state="{state}" phase_index={self.phase_index} '
+            f'time_remaining_ms={self.remaining_ms} transitions={self.transitions}'
+        )
+
+
+def crc8(data: bytes) -> int:
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def read_varint(payload: bytes, offset: int) -> Tuple[int, int]:
+    value = 0
+    shift = 0
+    while True:
+        byte = payload[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value & 0xFFFFFFFF, offset
+        shift += 7
+
+
+def read_zigzag(payload: bytes, offset: int) -> Tuple[int, int]:
+    value, offset = read_varint(payload, offset)
+    return (value >> 1) ^ -(value & 1), offset
+
+
+class FrameReader:
+    """Splits a byte stream into frame payloads, across arbitrary chunk boundaries."""
+
+    def __init__(self) -> None:
+        self.buffer = bytearray()
+
+    def feed(self, chunk: bytes) -> List[bytes]:
+        """Returns the payload of every frame with a valid CRC completed by `chunk`.
+
+        A frame cut off at the end of the chunk is kept until the rest arrives.
+        """
+        self.buffer += chunk
+        data = self.buffer
+        payloads = []
+        i = 0
+        while i < len(data):
+            if data[i] != SYNC:
+                i += 1
+                continue
+            if i + 1 >= len(data):
+                break
+            length = data[i + 1]
+            end = i + 2 + length
+            if length < 2:
+                i += 1
+                continue
+            if end >= len(data):
+                break
+            if crc8(data[i + 1 : end]) != data[end]:
+                i += 1
+                continue
+            payloads.append(bytes(data[i + 2 : end]))
+            i = end + 1
+        del data[:i]
+        return payloads
+
+
+class Decoder:
+    def __init__(self) -> None:
+        self.previous: Optional[Record] = None
+        self.interval_ms = 0
+        self.lost_frames = 0
+
+    def decode(self, payload: bytes) -> Optional[Record]:
+        flags, seq = payload[0], payload[1]
+        offset = 2
+
+        if self.previous is not None:
+            self.lost_frames += (seq - self.previous.seq - 1) & 0xFF
+
+        if flags & FLAG_KEYFRAME:
+            self.interval_ms, offset = read_varint(payload, offset)
+            timestamp_ms, offset = read_varint(payload, offset)
+            state = payload[offset]
+            offset += 1
+            phase_index, offset = read_varint(payload, offset)
+            remaining_ms, offset = read_varint(payload, offset)
+            transitions, offset = read_varint(payload, offset)
+            record = Record(seq, True, timestamp_ms, state, phase_index, remaining_ms, transitions)
+        elif self.previous is None:
+            return None
+        else:
+            prev = self.previous
+            timestamp_ms = (prev.timestamp_ms + self.interval_ms) & 0xFFFFFFFF
+            if flags & (1 << FIELD_TIMESTAMP):
+                error, offset = read_zigzag(payload, offset)
+                timestamp_ms = (timestamp_ms + error) & 0xFFFFFFFF
+            state = prev.state
+            if flags & (1 << FIELD_STATE):
+                state = payload[offset]
+                offset += 1
+            phase_index = prev.phase_index
+            if flags & (1 << FIELD_PHASE_INDEX):
+                phase_index, offset = read_varint(payload, offset)
+
+            predicted = prev.remaining_ms
+            if prev.state == STATE_RUNNING and state == STATE_RUNNING:
+                elapsed = (timestamp_ms - prev.timestamp_ms) & 0xFFFFFFFF
+                predicted = max(prev.remaining_ms - elapsed, 0)
+            remaining_ms = predicted
+            if flags & (1 << FIELD_REMAINING):
+                error, offset = read_zigzag(payload, offset)
+                remaining_ms = (predicted + error) & 0xFFFFFFFF
+
+            transitions = prev.transitions
+            if flags & (1 << FIELD_TRANSITIONS):
+                increase, offset = read_varint(payload, offset)
+                transitions = (transitions + increase) & 0xFFFFFFFF
+
+            record = Record(seq, False, timestamp_ms, state, phase_index, remaining_ms, transitions)
+
+        self.previous = record
+        return record
+
+
+class StreamDecoder:
+    """Decodes records from chunks of a stream, as they arrive."""
+
+    def __init__(self) -> None:
+        self.frames = FrameReader()
+        self.decoder = Decoder()
+        self.bytes_read = 0
+
+    def feed(self, chunk: bytes) -> List[Record]:
+        self.bytes_read += len(chunk)
+        records = []
+        for payload in self.frames.feed(chunk):
+            record = self.decoder.decode(payload)
+            if record is not None:
+                records.append(record)
+        return records
+
+
+def decode_stream(data: bytes) -> Tuple[List[Record], Decoder]:
+    stream = StreamDecoder()
+    return stream.feed(data), stream.decoder
+
+
+def read_port(port: Any) -> Iterator[bytes]:
+    """Yields what a serial port receives until a read times out or hits EOF.
+
+    `port` only needs pyserial's `read(size)` and `in_waiting`.
+    """
+    while True:
+        chunk = port.read(port.in_waiting or 1)
+        if not chunk:
+            return
+        yield chunk
+
+
+def read_source(args: argparse.Namespace) -> BinaryIO:
+    if args.port:
+        import serial  # type: ignore[import-not-found]
+
+        return serial.Serial(args.port, args.baud, timeout=args.timeout)
+    if args.capture == '-':
+        return sys.stdin.buffer
+    return open(args.capture, 'rb')
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('capture', nargs='?', default='-', help='raw capture file, or - for stdin')
+    parser.add_argument('--port', help='read from a serial port instead (needs pyserial)')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--timeout', type=float, default=10.0, help='serial read timeout in seconds')
+    parser.add_argument('--stats', action='store_true', help='print bandwidth statistics at the end')
+    args = parser.parse_args()
+
+    stream = StreamDecoder()
+    records = []
+    with read_source(args) as source:
+        # A serial port is printed live, until it stays silent for --timeout
+        chunks = read_port(source) if args.port else [source.read()]
+        for chunk in chunks:
+            for record in stream.feed(chunk):
+                records.append(record)
+                print(record.to_line(), flush=True)
+
+    if args.stats and records:
+        text_bytes = sum(len(r.to_line()) + 1 for r in records)
+        print(
+            f'records={len(records)} binary_bytes={stream.bytes_read} '
+            f'binary_bytes_per_record={stream.bytes_read / len(records):.1f} '
+            f'text_bytes_per_record={text_bytes / len(records):.1f} '
+            f'lost_frames={stream.decoder.lost_frames}',
+            file=sys.stderr,
+        )
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())